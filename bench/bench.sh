@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+#
+# Benchmark zps against synthetic /proc trees.
+#
+# Usage: bench.sh <zps> <procfs_gen>
+#
+# Environment:
+#   BENCH_PIDS          process counts to test (1000 10000 100000)
+#   BENCH_ZOMBIE_RATIO  ratio of zombie processes (0.1)
+#   BENCH_RUNS          number of runs per mode (5)
+#   BENCH_CMD_LEN       length of the generated command lines (256)
+#
+# Prints one JSON object per (mode, pids) pair to stdout.
+
+set -e
+
+zps="${1:?usage: bench.sh <zps> <procfs_gen>}"
+gen="${2:?usage: bench.sh <zps> <procfs_gen>}"
+pids_list="${BENCH_PIDS:-1000 10000 100000}"
+zombie_ratio="${BENCH_ZOMBIE_RATIO:-0.1}"
+runs="${BENCH_RUNS:-5}"
+cmd_len="${BENCH_CMD_LEN:-256}"
+
+# Prefer a tmpfs so that disk I/O does not dominate the measurements
+if [ -d /dev/shm ] && [ -w /dev/shm ]; then
+    work_dir="$(mktemp -d /dev/shm/zps-bench.XXXXXX)"
+else
+    work_dir="$(mktemp -d)"
+fi
+trap 'rm -rf "$work_dir"' EXIT
+
+# Print the total milliseconds zps reports for a run with the given arguments
+# (measured inside zps, so that fork and exec are not included)
+time_ms() {
+    local out rc=0
+    out="$("$zps" "$@" --stats 2>&1 </dev/null)" || rc=$?
+    if [ "$rc" -ne 0 ]; then
+        echo "$zps $* exited with $rc" >&2
+        exit 1
+    fi
+    awk '$1 == "total" { print $2; found = 1 } END { exit !found }' \
+        <<<"$out" || {
+        echo "$zps $* did not report its total time" >&2
+        exit 1
+    }
+}
+
+for pids in $pids_list; do
+    root="$work_dir/proc-$pids"
+    "$gen" -n "$pids" -z "$zombie_ratio" -c "$cmd_len" "$root"
+    # The generated PIDs may be real ones, so only send SIGCHLD to them
+    for mode in "" "-a" "-t 10" "-r -s CHLD" "--count"; do
+        samples=""
+        for _ in $(seq "$runs"); do
+            # shellcheck disable=SC2086
+            samples+="$(time_ms --proc-root "$root" -n $mode)"$'\n'
+        done
+        samples="$(sort -n <<<"$samples" | sed '/^$/d')"
+        min="$(echo "$samples" | head -n 1)"
+        max="$(echo "$samples" | tail -n 1)"
+        median="$(echo "$samples" | sed -n "$(((runs + 1) / 2))p")"
+        printf '{"mode":"%s","pids":%s,"zombie_ratio":%s,"runs":%s,' \
+            "${mode:-default}" "$pids" "$zombie_ratio" "$runs"
+        printf '"min_ms":%s,"median_ms":%s,"max_ms":%s}\n' \
+            "$min" "$median" "$max"
+    done
+    rm -rf "$root"
+done
@@ -0,0 +1,310 @@
+/**!
+ * Microbenchmarks for the hot paths of zps.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/zps.h"
+
+/* Maximum number of repetitions */
+#define MAX_REPS 1000
+
+/* Stat lines to parse, including the ones that are tricky to parse */
+static const char *const stat_corpus[] = {
+    /* Regular processes */
+    "1 (systemd) S 0 1 1 0 -1 4194560 51874 2301543 127 1417 190 321 6917 "
+    "2543 20 0 1 0 9 23195648 3211 18446744073709551615 1 1 0 0 0 0 "
+    "671173123 4096 1260 0 0 0 17 2 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+    "40321 (bash) S 40320 40321 40321 34816 40400 4194304 5873 43212 0 12 "
+    "8 3 41 19 20 0 1 0 5231789 8982528 1329 18446744073709551615 1 1 0 0 "
+    "0 0 65536 3686404 1266761467 0 0 0 17 5 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+    /* Zombies (their start time is parsed as well) */
+    "40412 (sleep) Z 40321 40412 40321 34816 40400 4227148 91 0 0 0 0 0 0 "
+    "0 20 0 1 0 5232001 0 0 18446744073709551615 0 0 0 0 0 0 0 0 0 0 0 0 "
+    "17 3 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+    "40413 (a) (b) Z 40321 40412 40321 34816 40400 4227148 91 0 0 0 0 0 0 "
+    "0 20 0 1 0 5232002 0 0 18446744073709551615 0 0 0 0 0 0 0 0 0 0 0 0 "
+    "17 3 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+    /* Names with parentheses and spaces */
+    "777 (x ) y )) S 1 777 777 0 -1 4194560 0 0 0 0 0 0 0 0 20 0 1 0 "
+    "100 0 0 18446744073709551615 0 0 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0\n",
+    "778 ()) S 1 778 778 0 -1 4194560 0 0 0 0 0 0 0 0 20 0 1 0 101 0 0\n",
+    "779 (((((((((((((((() S 1 779 779 0 -1 4194560 0 0 0 0 0 0 0 0 20 0 "
+    "1 0 102 0 0\n",
+    /* Kernel thread */
+    "1234 (kworker/3:1-events) I 2 0 0 0 -1 69238880 0 0 0 0 0 12 0 0 20 0 "
+    "1 0 322 0 0 18446744073709551615 0 0 0 0 0 0 0 2147483647 0 0 0 0 17 "
+    "3 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+    /* Malformed lines */
+    "",
+    "42",
+    "42 (no closing paren S 1",
+    "42 (truncated)",
+    "42 (truncated) Z 1 2 3",
+};
+
+/* Signals as the user might give them */
+static const char *const sig_corpus[] = {
+    "9", "15", "SIGTERM", "term", "KILL", "sigusr1", "WINCH", "bogus", "64",
+};
+
+/* Prevents the compiler from optimizing the benchmarked calls away */
+static volatile long sink;
+
+/* Context shared by the benchmarked operations */
+struct bench_ctx {
+    /* Index of the next corpus entry */
+    size_t i;
+    /* Open `/proc` directory */
+    int proc_fd;
+    /* Stream to write formatted output to */
+    FILE *null;
+    /* Process information to format */
+    struct zps_proc proc_stats;
+};
+
+/* Struct describing a benchmarked operation */
+struct bench {
+    /* Name of the benchmark */
+    const char *name;
+    /* Function running the operation once */
+    void (*op)(struct bench_ctx *ctx);
+};
+
+static void bench_parse_stat_content(struct bench_ctx *ctx)
+{
+    char stat_buf[MAX_BUF_SIZE];
+    const char *const line =
+        stat_corpus[ctx->i++ % (sizeof(stat_corpus) / sizeof(*stat_corpus))];
+
+    /* The parser modifies its input, so it needs a fresh copy */
+    strcpy(stat_buf, line);
+    sink += zps_parse_stat_content(stat_buf, &ctx->proc_stats);
+}
+
+static void bench_read_file(struct bench_ctx *ctx)
+{
+    char buf[MAX_BUF_SIZE];
+
+    sink += zps_read_file(ctx->proc_fd, buf, sizeof(buf), NULL, "%s/%s", "self",
+                          STAT_FILE);
+}
+
+static void bench_user_signal(struct bench_ctx *ctx)
+{
+    sink += zps_user_signal(
+        sig_corpus[ctx->i++ % (sizeof(sig_corpus) / sizeof(*sig_corpus))]);
+}
+
+static void bench_sig_str_to_num(struct bench_ctx *ctx)
+{
+    sink += zps_sig_str_to_num(
+        sig_corpus[ctx->i++ % (sizeof(sig_corpus) / sizeof(*sig_corpus))]);
+}
+
+static void bench_cfprintf(struct bench_ctx *ctx)
+{
+    const struct zps_proc *const proc_stats = &ctx->proc_stats;
+
+    cfprintf(ctx->i++ & 1 ? ANSI_FG_RED : ANSI_FG_NORMAL, true, ctx->null,
+             "%-*d %-*d %-*c %*.*s %s\n", PID_COL_WIDTH, proc_stats->pid,
+             PPID_COL_WIDTH, proc_stats->ppid, STATE_COL_WIDTH,
+             proc_stats->state, NAME_COL_WIDTH, NAME_COL_WIDTH,
+             proc_stats->name, proc_stats->cmd);
+}
+
+static const struct bench benches[] = {
+    {"parse_stat_content", bench_parse_stat_content},
+    {"read_file", bench_read_file},
+    {"user_signal", bench_user_signal},
+    {"sig_str_to_num", bench_sig_str_to_num},
+    {"cfprintf", bench_cfprintf},
+};
+
+/*!
+ * Returns the current time of the monotonic clock.
+ *
+ * @return Time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*!
+ * Open a counter of the CPU cycles spent by this process in user space.
+ *
+ * @return File descriptor of the counter, `-1` if it is not available
+ */
+static int cycles_open(void)
+{
+    struct perf_event_attr attr = {0};
+
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/*!
+ * Read the current value of the cycle counter.
+ *
+ * @param[in] fd File descriptor returned by `cycles_open()`
+ *
+ * @return Number of cycles, `0` if the counter is not available
+ */
+static uint64_t cycles_read(int fd)
+{
+    uint64_t cycles = 0;
+
+    if (fd == -1 || read(fd, &cycles, sizeof(cycles)) != sizeof(cycles)) {
+        return 0;
+    }
+    return cycles;
+}
+
+static int double_cmp(const void *a, const void *b)
+{
+    const double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*!
+ * Print usage and exit
+ *
+ * @param[in] status Exit status to use
+ */
+static void __attribute__((noreturn)) usage_exit(int status)
+{
+    fprintf(status ? stderr : stdout,
+            "Usage: microbench [options] [benchmark...]\n\n"
+            "Options:\n"
+            "  -n <ops>   operations per repetition (default: 100000)\n"
+            "  -r <reps>  number of repetitions (default: 10, max: %d)\n"
+            "  -w <ops>   warm-up operations (default: 10000)\n",
+            MAX_REPS);
+    exit(status);
+}
+
+/*!
+ * Entry point
+ */
+int main(int argc, char *argv[])
+{
+    long ops = 100000, reps = 10, warmup = 10000;
+    double ns_op[MAX_REPS], cycles_op[MAX_REPS];
+    char cmd[] = "/usr/bin/bash --login -i";
+
+    for (int opt; (opt = getopt(argc, argv, "n:r:w:h")) != -1;) {
+        switch (opt) {
+        case 'n':
+            ops = strtol(optarg, NULL, 10);
+            break;
+        case 'r':
+            reps = strtol(optarg, NULL, 10);
+            break;
+        case 'w':
+            warmup = strtol(optarg, NULL, 10);
+            break;
+        case 'h':
+            usage_exit(EXIT_SUCCESS);
+        default:
+            usage_exit(EXIT_FAILURE);
+        }
+    }
+    if (ops <= 0 || reps <= 0 || reps > MAX_REPS || warmup < 0) {
+        usage_exit(EXIT_FAILURE);
+    }
+
+    struct bench_ctx ctx = {
+        .proc_fd = open(ZPS_PROC_FILESYSTEM, O_RDONLY | O_DIRECTORY),
+        .null    = fopen("/dev/null", "w"),
+    };
+    if (ctx.proc_fd == -1 || !ctx.null) {
+        perror("open");
+        return EXIT_FAILURE;
+    }
+    ctx.proc_stats = (struct zps_proc){
+        .pid = 40321, .ppid = 40320, .state = 'S', .name = "bash", .cmd = cmd};
+    const int cycles_fd = cycles_open();
+
+    printf("%-20s %10s %10s %10s %10s %12s\n", "BENCHMARK", "MIN NS/OP",
+           "MED NS/OP", "MAX NS/OP", "STDDEV", "CYCLES/OP");
+    for (size_t b = 0; b < sizeof(benches) / sizeof(*benches); ++b) {
+        const struct bench *const bench = &benches[b];
+        /* Only run the benchmarks given as arguments (if any) */
+        bool selected = optind == argc;
+        for (int i = optind; i < argc; ++i) {
+            selected |= !strcmp(argv[i], bench->name);
+        }
+        if (!selected) {
+            continue;
+        }
+
+        for (long i = 0; i < warmup; ++i) {
+            bench->op(&ctx);
+        }
+        double mean = 0;
+        for (long r = 0; r < reps; ++r) {
+            const uint64_t cycles = cycles_read(cycles_fd);
+            const uint64_t begin  = now_ns();
+            for (long i = 0; i < ops; ++i) {
+                bench->op(&ctx);
+            }
+            ns_op[r]     = (double)(now_ns() - begin) / ops;
+            cycles_op[r] = (double)(cycles_read(cycles_fd) - cycles) / ops;
+            mean += ns_op[r] / reps;
+        }
+        double variance = 0;
+        for (long r = 0; r < reps; ++r) {
+            variance += (ns_op[r] - mean) * (ns_op[r] - mean) / reps;
+        }
+        qsort(ns_op, reps, sizeof(*ns_op), double_cmp);
+        qsort(cycles_op, reps, sizeof(*cycles_op), double_cmp);
+
+        printf("%-20s %10.1f %10.1f %10.1f %10.1f ", bench->name, ns_op[0],
+               ns_op[reps / 2], ns_op[reps - 1], sqrt(variance));
+        if (cycles_fd == -1) {
+            printf("%12s\n", "n/a");
+        } else {
+            printf("%12.1f\n", cycles_op[reps / 2]);
+        }
+    }
+
+    if (cycles_fd != -1) {
+        close(cycles_fd);
+    }
+    close(ctx.proc_fd);
+    fclose(ctx.null);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/**!
+ * Generates a synthetic `/proc` tree for benchmarking zps at scale.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/*
+ * First generated PID (the one the kernel wraps around to). The generated
+ * PIDs stay below `PID_MAX_LIMIT`, so they may belong to real processes:
+ * only send harmless signals (e.g. `SIGCHLD`) to the generated parents.
+ */
+#define PID_BASE 300
+/* Maximum PID of the kernel on 64-bit systems */
+#define PID_MAX_LIMIT (4 * 1024 * 1024)
+/* Number of zombie parents the zombies are spread over */
+#define DEFAULT_PARENTS 64
+
+/* Process names, including the ones that are tricky to parse */
+static const char *const names[] = {
+    "bash", "sshd", "(sd-pam)", "a) (b", "x ) y )", "worker (1)",
+    "long-name-15chr", "java", ")", "((", "node", "nginx: worker",
+};
+
+/*!
+ * Write `len` bytes of `buf` to the file at `path`.
+ *
+ * @param[in] path Path of the file to create
+ * @param[in] buf  Buffer to write
+ * @param[in] len  Number of bytes to write
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int write_file(const char *path, const char *buf, size_t len)
+{
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    const ssize_t rc = write(fd, buf, len);
+    close(fd);
+    return rc == (ssize_t)len ? 0 : -1;
+}
+
+/*!
+ * Print usage and exit
+ *
+ * @param[in] status Exit status to use
+ */
+static void __attribute__((noreturn)) usage_exit(int status)
+{
+    fprintf(status ? stderr : stdout,
+            "Usage: procfs_gen [options] <dir>\n\n"
+            "Options:\n"
+            "  -n <pids>   number of processes (default: 10000)\n"
+            "  -z <ratio>  ratio of zombie processes (default: 0.1)\n"
+            "  -k <ratio>  ratio of kernel threads (default: 0.05)\n"
+            "  -p <n>      number of zombie parents (default: %d)\n"
+            "  -c <len>    length of the command lines (default: 256)\n",
+            DEFAULT_PARENTS);
+    exit(status);
+}
+
+/*!
+ * Parse a number option or exit with the usage.
+ *
+ * @param[in] str Option argument to parse
+ * @param[in] max Maximum value to accept
+ *
+ * @return Number parsed from the whole argument
+ */
+static unsigned long parse_number(const char *str, unsigned long max)
+{
+    char *end = NULL;
+
+    errno                     = 0;
+    const unsigned long value = strtoul(str, &end, 10);
+    if (errno || end == str || *end || *str == '-' || value > max) {
+        usage_exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+/*!
+ * Parse a ratio option (between `0` and `1`) or exit with the usage.
+ *
+ * @param[in] str Option argument to parse
+ *
+ * @return Ratio parsed from the whole argument
+ */
+static double parse_ratio(const char *str)
+{
+    char *end = NULL;
+
+    errno              = 0;
+    const double value = strtod(str, &end);
+    if (errno || end == str || *end || !(value >= 0 && value <= 1)) {
+        usage_exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+/*!
+ * Entry point
+ */
+int main(int argc, char *argv[])
+{
+    unsigned long pids = 10000, parents = DEFAULT_PARENTS, cmd_len = 256;
+    double zombie_ratio = 0.1, kthread_ratio = 0.05;
+    char path[4096], buf[8192];
+
+    for (int opt; (opt = getopt(argc, argv, "n:z:k:p:c:h")) != -1;) {
+        switch (opt) {
+        case 'n':
+            pids = parse_number(optarg, PID_MAX_LIMIT - PID_BASE);
+            break;
+        case 'z':
+            zombie_ratio = parse_ratio(optarg);
+            break;
+        case 'k':
+            kthread_ratio = parse_ratio(optarg);
+            break;
+        case 'p':
+            parents = parse_number(optarg, ULONG_MAX);
+            break;
+        case 'c':
+            cmd_len = parse_number(optarg, sizeof(buf) - 1);
+            break;
+        case 'h':
+            usage_exit(EXIT_SUCCESS);
+        default:
+            usage_exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1 || !parents || parents > pids) {
+        usage_exit(EXIT_FAILURE);
+    }
+    const char *const root = argv[optind];
+    if (mkdir(root, 0755) && errno != EEXIST) {
+        perror(root);
+        return EXIT_FAILURE;
+    }
+    snprintf(path, sizeof(path), "%s/uptime", root);
+    if (write_file(path, "100000.00 100000.00\n", 20)) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    const unsigned long zombies  = pids * zombie_ratio;
+    const unsigned long kthreads = pids * kthread_ratio;
+    for (unsigned long i = 0; i < pids; ++i) {
+        const unsigned long pid = PID_BASE + i;
+        /* The first PIDs are the zombie parents, followed by the zombies */
+        const int zombie  = i >= parents && i < parents + zombies;
+        const int kthread = !zombie && i >= pids - kthreads;
+        const unsigned long ppid =
+            zombie ? PID_BASE + (i - parents) % parents : kthread ? 2 : 1;
+        const char *const name = names[i % (sizeof(names) / sizeof(*names))];
+
+        snprintf(path, sizeof(path), "%s/%lu", root, pid);
+        if (mkdir(path, 0755) && errno != EEXIST) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+
+        int len = snprintf(buf, sizeof(buf),
+                           "%lu (%s) %c %lu %lu %lu 0 -1 4194560 1021 0 0 0 "
+                           "2 1 0 0 20 0 1 0 %lu 12566528 1403 "
+                           "18446744073709551615 1 1 0 0 0 0 0 3670020 "
+                           "1266777851 0 0 0 17 3 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+                           pid, name, zombie ? 'Z' : kthread ? 'I' : 'S', ppid,
+                           pid, pid, 1000 + i);
+        snprintf(path, sizeof(path), "%s/%lu/stat", root, pid);
+        if (write_file(path, buf, len)) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+
+        /* Zombies and kernel threads have an empty command line */
+        len = 0;
+        if (!zombie && !kthread) {
+            for (; (unsigned long)len < cmd_len; ++len) {
+                buf[len] = len % 16 == 15 ? '\0' : 'a' + len % 26;
+            }
+        }
+        snprintf(path, sizeof(path), "%s/%lu/cmdline", root, pid);
+        if (write_file(path, buf, len)) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+/**!
+ * Counts the zombie processes with libzps, the process scanner of zps.
+ * It also defines functions named like the internals of the library,
+ * so that linking it checks that the library does not clash with them.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libzps.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Names of functions of the program that are also used inside of zps */
+int read_file(const char *path);
+int user_signal(const char *sig_str);
+int get_proc_stats(void);
+
+int read_file(const char *path)
+{
+    return path ? 0 : -1;
+}
+
+int user_signal(const char *sig_str)
+{
+    return sig_str ? atoi(sig_str) : -1;
+}
+
+int get_proc_stats(void)
+{
+    return 0;
+}
+
+static int on_zombie(const struct zps_proc *proc_stats, void *userdata)
+{
+    (void)proc_stats;
+    ++*(size_t *)userdata;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *const proc_root = argc > 1 ? argv[1] : ZPS_PROC_FILESYSTEM;
+    struct zps_ctx *const ctx   = zps_ctx_new(proc_root, 0);
+    if (!ctx) {
+        perror("zps_ctx_new");
+        return EXIT_FAILURE;
+    }
+    const struct zps_filter filter = {.zombies_only = true, .skip_cmd = true};
+    size_t zombies                 = 0;
+    const int rc = zps_scan(ctx, &filter, on_zombie, &zombies);
+    zps_ctx_free(ctx);
+    if (rc) {
+        perror("zps_scan");
+        return EXIT_FAILURE;
+    }
+    printf("%zu\n", zombies);
+
+    /* The own definitions are the ones called here */
+    return read_file(proc_root) || user_signal("0") || get_proc_stats()
+               ? EXIT_FAILURE
+               : EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
  * or defunct process is a process that has completed execution but still
  * has an entry in the process table. (Wikipedia)
  * This program illustrates how zombie or defunct processes are created.
+ * It can also create lots of them for testing zps under load.
  * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -18,30 +19,338 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+/* Enum for what the parents do when they are signaled */
+enum parent_mode {
+    /* Terminate (the default action) so that the zombies get reparented */
+    MODE_EXIT = 0,
+    /* Reap all zombies and keep running */
+    MODE_REAP,
+    /* Ignore the signal */
+    MODE_IGNORE,
+};
+
+/* Struct for keeping track of the options */
+struct zproc_opts {
+    /* Number of zombie parents */
+    unsigned long parents;
+    /* Number of zombies per parent */
+    unsigned long zombies;
+    /* Number of zombies replaced per second by each parent */
+    double churn;
+    /* Number of nested subreapers above the parents */
+    unsigned long subreapers;
+    /* What the parents and subreapers do when they are signaled */
+    enum parent_mode mode;
+    /* Boolean value for creating zombies with a running thread */
+    bool threaded;
+    /* Boolean value for not printing every created process */
+    bool quiet;
+    /* Seconds to run for */
+    unsigned int sleep_seconds;
+};
+
+/* Set by the signal handler when the zombies should be reaped */
+static volatile sig_atomic_t reap_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    reap_requested = 1;
+}
+
+/*!
+ * Returns the current time of the monotonic clock.
+ *
+ * @return Time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*!
+ * Sleep until the given time (or until a signal arrives).
+ *
+ * @param[in] deadline Time of the monotonic clock to wake up at
+ */
+static void sleep_until(uint64_t deadline)
+{
+    const uint64_t now = now_ns();
+    if (now >= deadline) {
+        return;
+    }
+    const struct timespec ts = {
+        .tv_sec  = (deadline - now) / 1000000000,
+        .tv_nsec = (deadline - now) % 1000000000,
+    };
+    nanosleep(&ts, NULL);
+}
+
+/*!
+ * Thread keeping a threaded zombie alive.
+ *
+ * @param[in] arg Pointer to the number of seconds to run for
+ */
+static void *zombie_thread(void *arg)
+{
+    sleep(*(const unsigned int *)arg);
+    return NULL;
+}
+
+/*!
+ * Fork a child that becomes a zombie right away.
+ *
+ * A threaded zombie only exits its main thread, so it shows up as a zombie
+ * while another thread is still running and it cannot be reaped yet.
+ *
+ * @param[in] opts Pointer to the options
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int spawn_zombie(const struct zproc_opts *opts)
+{
+    const pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        return -1;
+    }
+    if (pid) {
+        return 0;
+    }
+    if (!opts->quiet) {
+        fprintf(stderr, "PID: %d\n", getpid());
+    }
+    if (opts->threaded) {
+        pthread_t thread;
+        if (!pthread_create(&thread, NULL, zombie_thread,
+                            (void *)&opts->sleep_seconds)) {
+            pthread_exit(NULL);
+        }
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/*!
+ * Set up how the current process reacts to signals.
+ *
+ * @param[in] mode What to do when signaled
+ */
+static void set_mode(enum parent_mode mode)
+{
+    struct sigaction action = {0};
+
+    if (mode == MODE_EXIT) {
+        return;
+    }
+    action.sa_handler = mode == MODE_REAP ? on_signal : SIG_IGN;
+    sigemptyset(&action.sa_mask);
+    /* Keep `SIGCHLD` (ignoring it reaps the zombies) and Ctrl+C working */
+    for (int sig = 1; sig < NSIG; ++sig) {
+        if (sig != SIGCHLD && sig != SIGINT) {
+            sigaction(sig, &action, NULL);
+        }
+    }
+}
+
+/*!
+ * Run as a zombie parent (or as a subreaper if `zombies` is zero) until
+ * the deadline: reap the zombies when signaled (in reap mode) and replace
+ * them with new ones at the churn rate.
+ *
+ * @param[in] opts     Pointer to the options
+ * @param[in] zombies  Number of zombies to create
+ * @param[in] deadline Time of the monotonic clock to exit at
+ */
+static void run_parent(const struct zproc_opts *opts, unsigned long zombies,
+                       uint64_t deadline)
+{
+    unsigned long created = 0;
+    for (; created < zombies && !spawn_zombie(opts); ++created) {
+    }
+    if (!opts->quiet) {
+        fprintf(stderr, "PPID: %d (%lu zombies)\n", getpid(), created);
+    }
+
+    const bool churn      = zombies && opts->churn > 0;
+    const uint64_t period = churn ? 1000000000 / opts->churn : 0;
+    uint64_t next_churn   = now_ns() + period;
+    for (uint64_t now = now_ns(); now < deadline; now = now_ns()) {
+        if (reap_requested) {
+            reap_requested = 0;
+            unsigned long reaped = 0;
+            for (; waitpid(-1, NULL, WNOHANG) > 0; ++reaped) {
+            }
+            fprintf(stderr, "PPID: %d reaped %lu zombies\n", getpid(),
+                    reaped);
+        }
+        uint64_t wake = deadline;
+        if (churn) {
+            /* Replace the oldest zombies we are behind on */
+            for (; next_churn <= now; next_churn += period) {
+                waitpid(-1, NULL, WNOHANG);
+                spawn_zombie(opts);
+            }
+            wake = next_churn < deadline ? next_churn : deadline;
+        }
+        sleep_until(wake);
+    }
+}
+
+/*!
+ * Create the process tree: the chain of subreapers (if any) and the zombie
+ * parents below them.
+ *
+ * @param[in] opts     Pointer to the options
+ * @param[in] depth    Number of subreapers above the current process
+ * @param[in] deadline Time of the monotonic clock to exit at
+ */
+static void run_tree(const struct zproc_opts *opts, unsigned long depth,
+                     uint64_t deadline)
+{
+    set_mode(opts->mode);
+    /* A single parent without subreapers is the process itself */
+    if (!opts->subreapers && opts->parents == 1) {
+        run_parent(opts, opts->zombies, deadline);
+        return;
+    }
+    if (depth < opts->subreapers) {
+        if (prctl(PR_SET_CHILD_SUBREAPER, 1) == -1) {
+            perror("prctl");
+        }
+    }
+    if (depth + 1 < opts->subreapers) {
+        const pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+        } else if (!pid) {
+            run_tree(opts, depth + 1, deadline);
+            exit(EXIT_SUCCESS);
+        }
+    } else {
+        for (unsigned long i = 0; i < opts->parents; ++i) {
+            const pid_t pid = fork();
+            if (pid == -1) {
+                perror("fork");
+                break;
+            } else if (!pid) {
+                run_parent(opts, opts->zombies, deadline);
+                exit(EXIT_SUCCESS);
+            }
+        }
+    }
+    if (!opts->quiet && opts->subreapers) {
+        fprintf(stderr, "SUBREAPER: %d\n", getpid());
+    }
+    /* Adopt the zombies of exiting parents without reaping them */
+    run_parent(opts, 0, deadline);
+}
+
+/*!
+ * Print usage and exit
+ *
+ * @param[in] status Exit status to use
+ */
+static void __attribute__((noreturn)) usage_exit(int status)
+{
+    fprintf(status ? stderr : stdout,
+            "Usage: zproc [options] [sleep]\n\n"
+            "Options:\n"
+            "  -p <n>     number of zombie parents (default: 1)\n"
+            "  -z <n>     number of zombies per parent (default: 1)\n"
+            "  -c <rate>  zombies replaced per second by each parent\n"
+            "  -m <mode>  what parents do when signaled: exit, reap or\n"
+            "             ignore (default: exit)\n"
+            "  -r <n>     nest the parents under <n> subreapers\n"
+            "  -t         keep a thread of each zombie running\n"
+            "  -q         do not print the created processes\n"
+            "  -h         show help\n\n"
+            "Exits after [sleep] seconds (default: 60).\n");
+    exit(status);
+}
+
 /*!
  * Entry point
  */
 int main(int argc, char *argv[])
 {
-    unsigned int sleep_seconds = 60;
-    if (argc == 2) { /* Parse command line argument. */
-        sscanf(argv[1], "%u", &sleep_seconds);
-    }
-    pid_t pid = fork();
-    if (pid > 0) { /* Parent process */
-        /**
-         * Sleep and eventually exit without the wait call.
-         * This will cause child process to be a defunct process.
-         */
-        fprintf(stderr, "PPID: %d\n", getpid());
-        sleep(sleep_seconds);
-    } else if (!pid) { /* Child process */
-        fprintf(stderr, "PID: %d\n", getpid());
+    struct zproc_opts opts = {
+        .parents       = 1,
+        .zombies       = 1,
+        .churn         = 0,
+        .subreapers    = 0,
+        .mode          = MODE_EXIT,
+        .threaded      = false,
+        .quiet         = false,
+        .sleep_seconds = 60,
+    };
+
+    for (int opt; (opt = getopt(argc, argv, "p:z:c:m:r:tqh")) != -1;) {
+        switch (opt) {
+        case 'p':
+            opts.parents = strtoul(optarg, NULL, 10);
+            break;
+        case 'z':
+            opts.zombies = strtoul(optarg, NULL, 10);
+            break;
+        case 'c':
+            opts.churn = strtod(optarg, NULL);
+            break;
+        case 'm':
+            if (!strcmp(optarg, "exit")) {
+                opts.mode = MODE_EXIT;
+            } else if (!strcmp(optarg, "reap")) {
+                opts.mode = MODE_REAP;
+            } else if (!strcmp(optarg, "ignore")) {
+                opts.mode = MODE_IGNORE;
+            } else {
+                usage_exit(EXIT_FAILURE);
+            }
+            break;
+        case 'r':
+            opts.subreapers = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            opts.threaded = true;
+            break;
+        case 'q':
+            opts.quiet = true;
+            break;
+        case 'h':
+            usage_exit(EXIT_SUCCESS);
+        default:
+            usage_exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) { /* Parse command line argument. */
+        sscanf(argv[optind], "%u", &opts.sleep_seconds);
     }
+    if (!opts.parents || opts.churn < 0) {
+        usage_exit(EXIT_FAILURE);
+    }
+
+    /**
+     * Sleep and eventually exit without the wait call.
+     * This will cause child processes to be defunct processes.
+     */
+    run_tree(&opts, 0, now_ns() + opts.sleep_seconds * 1000000000ULL);
     return EXIT_SUCCESS;
 }
@@ -5,19 +5,65 @@ set -e
 project_dir="$(pwd)/.."
 # Compile the example & run
 cd "${project_dir}/example"
-gcc -O3 -Wall zproc.c -o z.o
+gcc -O3 -Wall -pthread zproc.c -o z.o
 ./z.o &>/dev/null &
 ./z.o &>/dev/null &
+./z.o -q -p 4 -z 50 -m reap -r 1 &>/dev/null &
+./z.o -q -p 2 -z 10 -m ignore -t &>/dev/null &
 # Compile the main source & run
 cd "${project_dir}/src"
-gcc -fprofile-arcs -ftest-coverage -s -O3 -Wall -Wextra -pedantic zps.c -o zps
+gcc -fprofile-arcs -ftest-coverage -s -O3 -Wall -Wextra -pedantic ./*.c -o zps
 ./zps -v && ./zps -h && printf '1' | ./zps -p
 ./zps -a && ./zps -r
 ./zps -q && ./zps -s 9 && ./zps -s SIGTERM && ./zps -s term
 ./zps -n
+./zps -t 3 && ./zps -t 1 -r
+./zps --stats && ./zps -a --cmd-len 8 --stats
+printf 'name z.o ignore\nuid 0 escalate CHLD,TERM\n' > zps.policy
+./zps -r --policy zps.policy
+printf 'name nomatch ignore\n' > zps.policy
+timeout -s INT 3 ./zps -r -q -w 1 --policy zps.policy || [ $? -eq 124 ]
+./zps -r --journal zps.ndjson && cat zps.ndjson
+./zps --stream && ./zps --stream -a -n
+./zps -r --max-memory 1
+./zps -r --budget 5
+# Count the zombies of a parent ignoring the signals (2 parents, 20 zombies)
+../example/z.o -q -p 2 -z 10 -m ignore 30 &>/dev/null &
+sleep 1
+count="$(./zps --count)"
+awk '{ exit !($2 >= 20 && $4 >= 2) }' <<< "$count"
+rc=0 && ./zps --count --threshold 0 --stats || rc=$?
+[ "$rc" -eq 1 ]
+./zps --save a.snap && ./zps --save b.snap && ./zps --diff a.snap b.snap
+# Check the modes against generated process tables (4 parents, 20 zombies)
+gcc -O3 -Wall -Wextra -pedantic ../bench/procfs_gen.c -o procfs_gen
+proc_dir="$(mktemp -d)"
+./procfs_gen -n 100 -z 0.2 -k 0 -p 4 "${proc_dir}/a"
+./procfs_gen -n 103 -z 0.2 -k 0 -p 4 "${proc_dir}/b"
+rm -r "${proc_dir}/b/$(ls "${proc_dir}/a" | sort -n | tail -n 1)"
+[ "$(./zps --proc-root "${proc_dir}/a" --count)" == 'zombies: 20 parents: 4' ]
+rc=0 && ./zps --proc-root "${proc_dir}/a" --count --threshold 19 || rc=$?
+[ "$rc" -eq 1 ]
+./zps --proc-root "${proc_dir}/a" --count --threshold 20
+./zps --proc-root "${proc_dir}/a" --save a.snap
+./zps --proc-root "${proc_dir}/b" --save b.snap
+./zps --diff a.snap b.snap > zps.diff
+grep -qx 'New: 3' zps.diff && grep -qx 'Vanished: 1' zps.diff
+grep -qx 'Changed: 0' zps.diff
+# Stream mode signals each parent once
+./zps --proc-root "${proc_dir}/a" --stream -s CHLD --journal zps.stream
+[ "$(wc -l < zps.stream)" -eq 4 ]
+[ "$(grep -o '"ppid":[0-9]*' zps.stream | sort -u | wc -l)" -eq 4 ]
+rm -r "${proc_dir}"
+# Link a program defining the names of the library internals to libzps
+gcc -O3 -Wall -Wextra -pedantic -c libzps.c proc.c signals.c bpf.c
+ar rcs libzps.a libzps.o proc.o signals.o bpf.o
+gcc -O3 -Wall -Wextra -pedantic -I. ../example/embed.c libzps.a -o embed
+./embed
 # Print code coverage information
-gcov zps.c
+gcov zps-*.gcno
 # Send report to codecov
 [ "$UPLOAD" == 'true' ] && bash <(curl -s https://codecov.io/bash)
 # Cleanup
-rm -v zps zps.c.* zps.gc*
+rm -v zps embed procfs_gen libzps.a ./*.o ./*.gcov zps-*.gc* ./*.snap \
+    zps.policy zps.ndjson zps.diff zps.stream
@@ -0,0 +1,235 @@
+/**!
+ * libzps, the process scanner of zps as a library.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "zps.h"
+
+#ifdef ZPS_BPF
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <linux/types.h>
+
+#include "bpf/record.h"
+#include "zps.skel.h"
+
+/* Inode number of the initial PID namespace (`PROC_PID_INIT_INO`) */
+#define PID_NS_INIT_INO 0xEFFFFFFCU
+/* Number of records read at once */
+#define BPF_READ_RECORDS 256
+
+/* Struct for the loaded task iterator */
+struct zps_bpf {
+    struct zps_iter *skel;
+    struct bpf_link *link;
+    /* Nanoseconds per clock tick (for the start times) */
+    unsigned long long tick_ns;
+};
+
+/* Silence the messages of libbpf, failures fall back to `/proc` */
+static int zps_bpf_print(enum libbpf_print_level level, const char *format,
+                         va_list args)
+{
+    (void)level;
+    (void)format;
+    (void)args;
+    return 0;
+}
+
+/*!
+ * Load and attach the task iterator.
+ *
+ * The iterator reports the tasks of the initial PID namespace only, so it is
+ * not used from other namespaces.
+ *
+ * @param[in] dirfd Open `/proc` directory
+ *
+ * @return Pointer to the loaded iterator, `NULL` if BPF is not available
+ */
+struct zps_bpf *zps_bpf_open(int dirfd)
+{
+    struct stat st = {0};
+
+    if (fstatat(dirfd, "self/ns/pid", &st, 0) ||
+        st.st_ino != PID_NS_INIT_INO) {
+        errno = EOPNOTSUPP;
+        return NULL;
+    }
+    struct zps_bpf *const bpf = calloc(1, sizeof(*bpf));
+    if (!bpf) {
+        return NULL;
+    }
+    libbpf_set_print(zps_bpf_print);
+    bpf->tick_ns = 1000000000ULL / sysconf(_SC_CLK_TCK);
+    bpf->skel    = zps_iter__open_and_load();
+    if (!bpf->skel ||
+        !(bpf->link = bpf_program__attach_iter(bpf->skel->progs.zps_zombies,
+                                               NULL))) {
+        zps_bpf_close(bpf);
+        return NULL;
+    }
+
+    return bpf;
+}
+
+/*!
+ * Detach and free the task iterator.
+ *
+ * @param[in] bpf Pointer to the iterator, may be `NULL`
+ *
+ * @return void
+ */
+void zps_bpf_close(struct zps_bpf *bpf)
+{
+    if (!bpf) {
+        return;
+    }
+    bpf_link__destroy(bpf->link);
+    zps_iter__destroy(bpf->skel);
+    free(bpf);
+}
+
+/*!
+ * Enumerate the zombies with the task iterator and call `cb` for each one
+ * matching the filter (as `zps_scan()` does).
+ *
+ * @param[in]     bpf      Pointer to the iterator
+ * @param[in,out] ctx      Pointer to the scan context
+ * @param[in]     filter   Pointer to the filter (only zombies are reported)
+ * @param[in]     cb       Function to call for every reported zombie
+ * @param[in]     userdata Pointer to pass to `cb`
+ *
+ * @return `-1` if the iteration could not be started (and `cb` was not
+ *         called), `1` if it failed after it was started (with `errno` set,
+ *         the reported zombies may be incomplete), otherwise `0` is returned
+ */
+int zps_bpf_scan(struct zps_bpf *bpf, struct zps_ctx *ctx,
+                 const struct zps_filter *filter, zps_scan_cb cb,
+                 void *userdata)
+{
+    struct zps_bpf_record records[BPF_READ_RECORDS];
+
+    assert(bpf);
+    assert(ctx);
+    assert(filter);
+    assert(cb);
+
+    struct zps_perf *const perf = ctx->perf;
+    uint64_t begin              = zps_perf_begin(perf);
+    const int fd                = bpf_iter_create(bpf_link__fd(bpf->link));
+    zps_perf_end(perf, ZPS_PHASE_OPEN, begin);
+    if (perf) {
+        ++perf->syscalls;
+    }
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* Records may be split between reads, keep the partial one */
+    size_t buffered = 0;
+    int rc          = 0;
+    for (bool done = false; !done;) {
+        begin           = zps_perf_begin(perf);
+        const ssize_t n = read(fd, (char *)records + buffered,
+                               sizeof(records) - buffered);
+        zps_perf_end(perf, ZPS_PHASE_ENUMERATE, begin);
+        if (perf) {
+            ++perf->syscalls;
+            perf->bytes_read += n > 0 ? n : 0;
+        }
+        if (n <= 0) {
+            if (n == -1 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            rc = n ? 1 : 0;
+            break;
+        }
+        buffered += n;
+
+        const size_t count = buffered / sizeof(*records);
+        for (size_t i = 0; i < count && !done; ++i) {
+            const struct zps_bpf_record *const record = &records[i];
+            if (filter->ppid && (pid_t)record->ppid != filter->ppid) {
+                continue;
+            }
+            struct zps_proc proc_stats = {
+                .pid       = record->pid,
+                .ppid      = record->ppid,
+                .state     = ZPS_STATE_ZOMBIE,
+                .starttime = record->start_boottime / bpf->tick_ns,
+                .cmd       = ctx->cmd_buf,
+            };
+            memcpy(proc_stats.name, record->comm, sizeof(proc_stats.name));
+            proc_stats.name[sizeof(proc_stats.name) - 1] = '\0';
+            /* Zombies have no command line */
+            ctx->cmd_buf[0] = '\0';
+            done            = cb(&proc_stats, userdata);
+        }
+        buffered -= count * sizeof(*records);
+        memmove(records, &records[count], buffered);
+    }
+    const int err = errno;
+    close(fd);
+    if (perf) {
+        ++perf->syscalls;
+    }
+    errno = err;
+
+    return rc;
+}
+#else
+/*!
+ * Stub of `zps_bpf_open()` for builds without BPF support.
+ *
+ * @param[in] dirfd Open `/proc` directory
+ *
+ * @return `NULL`
+ */
+struct zps_bpf *zps_bpf_open(int dirfd)
+{
+    (void)dirfd;
+    errno = ENOSYS;
+    return NULL;
+}
+
+void zps_bpf_close(struct zps_bpf *bpf)
+{
+    (void)bpf;
+}
+
+int zps_bpf_scan(struct zps_bpf *bpf, struct zps_ctx *ctx,
+                 const struct zps_filter *filter, zps_scan_cb cb,
+                 void *userdata)
+{
+    (void)bpf;
+    (void)ctx;
+    (void)filter;
+    (void)cb;
+    (void)userdata;
+    errno = ENOSYS;
+    return -1;
+}
+#endif
@@ -0,0 +1,36 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ZPS_BPF_RECORD_H
+#define ZPS_BPF_RECORD_H
+
+/* Length of the task names in the records (incl. '\0') */
+#define ZPS_BPF_COMM_LEN 16
+
+/*
+ * Fixed-size record of a zombie written by the `iter/task` program
+ * (shared by `zps.bpf.c` and `bpf.c`).
+ */
+struct zps_bpf_record {
+    __u32 pid;
+    __u32 ppid;
+    /* Start time in nanoseconds after boot (incl. suspend) */
+    __u64 start_boottime;
+    char comm[ZPS_BPF_COMM_LEN];
+};
+
+#endif // ZPS_BPF_RECORD_H
@@ -0,0 +1,64 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vmlinux.h"
+
+#include <bpf/bpf_core_read.h>
+#include <bpf/bpf_helpers.h>
+
+#include "record.h"
+
+/* `task_struct::exit_state` of zombies (include/linux/sched.h) */
+#define EXIT_ZOMBIE 0x00000020
+/* `task_struct::flags` of kernel threads (include/linux/sched.h) */
+#define PF_KTHREAD 0x00200000
+/* PID of `kthreadd` (`ZPS_KTHREADD_PID`) */
+#define KTHREADD_PID 2
+
+char LICENSE[] SEC("license") = "GPL";
+
+/*!
+ * Write a record for every zombie process to the iterator's file, so that
+ * nothing but the zombies has to be formatted and read.
+ *
+ * @param[in] ctx Iterator context holding the current task
+ *
+ * @return `0` to continue the iteration
+ */
+SEC("iter/task")
+int zps_zombies(struct bpf_iter__task *ctx)
+{
+    struct task_struct *task     = ctx->task;
+    struct zps_bpf_record record = {0};
+
+    /* Only the thread group leaders stand for the processes */
+    if (!task || task->pid != task->tgid ||
+        !(task->exit_state & EXIT_ZOMBIE) || (task->flags & PF_KTHREAD)) {
+        return 0;
+    }
+    record.ppid = BPF_CORE_READ(task, real_parent, tgid);
+    /* Skip the children of `kthreadd` as the scans of `/proc` do */
+    if (record.ppid == KTHREADD_PID) {
+        return 0;
+    }
+    record.pid            = task->tgid;
+    record.start_boottime = task->start_boottime;
+    bpf_probe_read_kernel_str(record.comm, sizeof(record.comm), task->comm);
+    bpf_seq_write(ctx->meta->seq, &record, sizeof(record));
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "zps.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX MAX_BUF_SIZE
+#endif
+
+/*!
+ * (Re)open the journal file for appending.
+ *
+ * @param[in,out] journal Pointer to the journal
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int journal_reopen(struct journal *journal)
+{
+    struct stat st = {0};
+
+    if (journal->fd != -1) {
+        close(journal->fd);
+    }
+    journal->fd = open(journal->path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                       0644);
+    if (journal->fd == -1 || fstat(journal->fd, &st)) {
+        return -1;
+    }
+    journal->file_sz = st.st_size;
+
+    return 0;
+}
+
+/*!
+ * Rename the journal file to `<path>.1` (replacing the previous one) and
+ * start a new one.
+ *
+ * @param[in,out] journal Pointer to the journal
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int journal_rotate(struct journal *journal)
+{
+    char rotated[PATH_MAX] = {0};
+
+    if (snprintf(rotated, sizeof(rotated), "%s.1", journal->path) >=
+        (int)sizeof(rotated)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if (rename(journal->path, rotated)) {
+        return -1;
+    }
+    return journal_reopen(journal);
+}
+
+/*!
+ * Escape a process name for a JSON string.
+ *
+ * Control characters, quotes, backslashes and non-ASCII bytes (which may be
+ * a truncated UTF-8 sequence) are escaped.
+ *
+ * @param[out] buf  Buffer to write to (at least `6 * strlen(name) + 1` bytes)
+ * @param[in]  name Null-terminated name to escape
+ *
+ * @return `buf`
+ */
+static char *journal_escape(char *buf, const char *name)
+{
+    char *out = buf;
+    for (const unsigned char *c = (const unsigned char *)name; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            *out++ = '\\';
+            *out++ = *c;
+        } else if (*c < 0x20 || *c >= 0x7f) {
+            out += sprintf(out, "\\u%04x", *c);
+        } else {
+            *out++ = *c;
+        }
+    }
+    *out = '\0';
+
+    return buf;
+}
+
+/*!
+ * Opens the journal file at `path` for appending the sent signals.
+ *
+ * The `journal_close()` function should be called on this return value
+ * in order to commit the remaining records and free the resources.
+ *
+ * @param[in] path  Path of the journal file
+ * @param[in] dirfd Open `/proc` directory to look up the parent names in
+ *
+ * @return Pointer to the allocated structure, `NULL` on error
+ */
+struct journal *journal_open(const char *path, int dirfd)
+{
+    assert(path);
+
+    struct journal *const journal = calloc(1, sizeof(*journal));
+    if (!journal) {
+        return NULL;
+    }
+    journal->path    = path;
+    journal->fd      = -1;
+    journal->dirfd   = dirfd;
+    journal->buf_cap = JOURNAL_BUF_SIZE;
+    journal->buf     = malloc(journal->buf_cap);
+    if (!journal->buf || journal_reopen(journal)) {
+        const int err = errno;
+        journal_close(journal);
+        errno = err;
+        return NULL;
+    }
+
+    return journal;
+}
+
+/*!
+ * Commit the remaining records and free the resources of the journal.
+ *
+ * @param[in] journal Pointer to the journal, may be `NULL`
+ *
+ * @return void
+ */
+void journal_close(struct journal *journal)
+{
+    if (!journal) {
+        return;
+    }
+    if (journal->fd != -1) {
+        journal_commit(journal);
+        close(journal->fd);
+    }
+    free(journal->buf);
+    free(journal);
+}
+
+/*!
+ * Look up the name of a parent to record.
+ *
+ * This has to be called before signaling the parent, which may terminate
+ * it. Consecutive lookups of the same parent are cached until the next
+ * commit.
+ *
+ * @param[in,out] journal Pointer to the journal
+ * @param[in]     ppid    PID of the parent
+ *
+ * @return Name of the parent (empty if it is gone), valid until the next call
+ */
+const char *journal_name(struct journal *journal, pid_t ppid)
+{
+    char pid_buf[32]             = {0};
+    struct zps_proc proc_stats = {0};
+
+    assert(journal);
+
+    if (journal->name_pid == ppid) {
+        return journal->name;
+    }
+    journal->name_pid = ppid;
+    journal->name[0]  = '\0';
+    snprintf(pid_buf, sizeof(pid_buf), "%d", ppid);
+    if (!zps_get_proc_stats(journal->dirfd, pid_buf, &proc_stats, NULL)) {
+        memcpy(journal->name, proc_stats.name, sizeof(journal->name));
+    }
+
+    return journal->name;
+}
+
+/*!
+ * Buffer the record of a sent signal as a line of JSON.
+ *
+ * A record that cannot be buffered is dropped and its error is kept in the
+ * `error` field of the journal.
+ *
+ * @param[in,out] journal Pointer to the journal
+ * @param[in]     pid     PID of the zombie
+ * @param[in]     ppid    PID of the signaled parent
+ * @param[in]     name    Name of the parent (see `journal_name()`)
+ * @param[in]     sig     Sent signal
+ * @param[in]     err     Error number of the failed `kill()`, `0` on success
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+int journal_record(struct journal *journal, pid_t pid, pid_t ppid,
+                   const char *name, int sig, int err)
+{
+    char escaped[6 * ZPS_TASK_COMM_LEN] = {0};
+    struct timespec now                 = {0};
+
+    assert(journal);
+    assert(name);
+
+    /* Leave enough room for the fixed fields and the error message */
+    const size_t max_len = sizeof(escaped) + MAX_BUF_SIZE;
+    if (journal->buf_cap - journal->buf_sz < max_len) {
+        size_t cap = journal->buf_cap * 2;
+        for (; cap - journal->buf_sz < max_len; cap *= 2) {
+        }
+        char *const buf = realloc(journal->buf, cap);
+        if (!buf) {
+            journal->error = journal->error ? journal->error : ENOMEM;
+            return -1;
+        }
+        journal->buf     = buf;
+        journal->buf_cap = cap;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    const int len = snprintf(
+        journal->buf + journal->buf_sz, journal->buf_cap - journal->buf_sz,
+        "{\"time\":%lld.%06ld,\"pid\":%d,\"ppid\":%d,\"name\":\"%s\","
+        "\"signal\":%d,\"result\":\"%s\"}\n",
+        (long long)now.tv_sec, now.tv_nsec / 1000, pid, ppid,
+        journal_escape(escaped, name), sig, err ? strerror(err) : "ok");
+    if (len < 0 || (size_t)len >= journal->buf_cap - journal->buf_sz) {
+        journal->error = journal->error ? journal->error : EOVERFLOW;
+        return -1;
+    }
+    journal->buf_sz += len;
+
+    return 0;
+}
+
+/*!
+ * Write the buffered records to the journal file and flush them to the disk.
+ *
+ * The file is rotated before the write if it would grow past
+ * `JOURNAL_MAX_SIZE`, so the records of a commit are never split.
+ *
+ * @param[in,out] journal Pointer to the journal
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+int journal_commit(struct journal *journal)
+{
+    assert(journal);
+
+    /* Parents may exit and their PIDs may be reused until the next commit */
+    journal->name_pid = 0;
+    if (!journal->buf_sz) {
+        return 0;
+    }
+    if (journal->file_sz &&
+        journal->file_sz + journal->buf_sz > JOURNAL_MAX_SIZE &&
+        journal_rotate(journal)) {
+        return -1;
+    }
+
+    size_t written = 0;
+    while (written < journal->buf_sz) {
+        const ssize_t n = write(journal->fd, journal->buf + written,
+                                journal->buf_sz - written);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* Keep the unwritten records for the next commit */
+            const int err = errno;
+            memmove(journal->buf, journal->buf + written,
+                    journal->buf_sz - written);
+            journal->buf_sz -= written;
+            journal->file_sz += written;
+            errno = err;
+            return -1;
+        }
+        written += n;
+    }
+    journal->file_sz += written;
+    journal->buf_sz = 0;
+
+    return fdatasync(journal->fd);
+}
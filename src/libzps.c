@@ -0,0 +1,489 @@
+/**!
+ * libzps, the process scanner of zps as a library.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libzps.h"
+#include "zps.h"
+
+/* Directory entry returned by `getdents64()` (see getdents(2)) */
+struct linux_dirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/*!
+ * Constructs a scan context for the given `/proc` filesystem.
+ *
+ * The `zps_ctx_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @param[in] proc_root Path of the `/proc` filesystem
+ * @param[in] cmd_len   Length to truncate the command lines to (at most
+ *                      `ZPS_CMD_MAX_LEN`)
+ *
+ * @return Pointer to the allocated structure, `NULL` on error (with `errno`
+ *         set)
+ */
+struct zps_ctx *zps_ctx_new(const char *proc_root, size_t cmd_len)
+{
+    assert(proc_root);
+
+    if (cmd_len > ZPS_CMD_MAX_LEN) {
+        errno = EINVAL;
+        return NULL;
+    }
+    struct zps_ctx *const ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        return NULL;
+    }
+    ctx->cmd_bufsiz = cmd_len + 1;
+    ctx->cmd_buf    = malloc(ctx->cmd_bufsiz);
+    ctx->dir        = opendir(proc_root);
+    if (!ctx->cmd_buf || !ctx->dir) {
+        zps_ctx_free(ctx);
+        return NULL;
+    }
+    ctx->dirfd = dirfd(ctx->dir);
+
+    return ctx;
+}
+
+/*!
+ * Free the resources of a scan context.
+ *
+ * @param[in] ctx Pointer to the context, may be `NULL`
+ *
+ * @return void
+ */
+void zps_ctx_free(struct zps_ctx *ctx)
+{
+    if (!ctx) {
+        return;
+    }
+    if (ctx->dir) {
+        closedir(ctx->dir);
+    }
+    zps_bpf_close(ctx->bpf);
+    free(ctx->cmd_buf);
+    free(ctx);
+}
+
+/*!
+ * Enable measuring the phases of the scans.
+ *
+ * @param[out] ctx  Pointer to the context
+ * @param[out] perf Pointer to the measurements to update, `NULL` to disable
+ *
+ * @return void
+ */
+void zps_ctx_set_perf(struct zps_ctx *ctx, struct zps_perf *perf)
+{
+    assert(ctx);
+
+    ctx->perf = perf;
+}
+
+/*!
+ * Pace the scans to use at most the given share of a CPU.
+ *
+ * The processes are scanned in slices with sleeps in between, which keep the
+ * CPU time (including the time spent in the kernel and in the callbacks)
+ * within the share of the elapsed time. Scans of zombies with the task
+ * iterator run in a single pass and are only followed by a sleep.
+ *
+ * @param[out] ctx  Pointer to the context
+ * @param[out] pace Pointer to the target share and the measurements of the
+ *                  last scan, `NULL` to disable
+ *
+ * @return void
+ */
+void zps_ctx_set_pace(struct zps_ctx *ctx, struct zps_pace *pace)
+{
+    assert(ctx);
+    assert(!pace || (pace->share > 0 && pace->share <= 1));
+
+    ctx->pace       = pace;
+    ctx->pace_slice = 64;
+}
+
+/*!
+ * Find the zombies with a BPF task iterator instead of reading `/proc`.
+ *
+ * The iterator walks the task list in the kernel and only reports the
+ * zombies, so it is only used for the scans of zombies. It requires a build
+ * with `ZPS_BPF`, the privileges to load BPF programs and the initial PID
+ * namespace (the context has to be for the real `/proc`).
+ *
+ * @param[in,out] ctx Pointer to the context
+ *
+ * @return `-1` if BPF is not available (the scans read `/proc`), otherwise
+ *         `0` is returned
+ */
+int zps_ctx_use_bpf(struct zps_ctx *ctx)
+{
+    assert(ctx);
+
+    if (!ctx->bpf) {
+        ctx->bpf = zps_bpf_open(ctx->dirfd);
+    }
+    return ctx->bpf ? 0 : -1;
+}
+
+/*!
+ * Returns the current time of the given clock.
+ *
+ * @param[in] clock Clock to read
+ *
+ * @return Time in nanoseconds
+ */
+static uint64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*!
+ * Sleep between two slices of a paced scan until the CPU time used by the
+ * scan is within its share of the elapsed time, and resize the next slice
+ * to take about `PACE_SLICE_NS` of CPU time.
+ *
+ * @param[in,out] ctx         Pointer to the context
+ * @param[in]     cpu_begin   CPU time of the thread when the scan started
+ * @param[in]     wall_begin  Monotonic time when the scan started
+ * @param[in]     slice_begin CPU time of the thread when the slice started
+ *
+ * @return CPU time of the thread when the next slice starts
+ */
+static uint64_t zps_pace(struct zps_ctx *ctx, uint64_t cpu_begin,
+                         uint64_t wall_begin, uint64_t slice_begin)
+{
+    struct zps_pace *const pace = ctx->pace;
+
+    const uint64_t cpu      = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    const uint64_t slice_ns = cpu - slice_begin;
+    if (slice_ns < PACE_SLICE_NS / 2 && ctx->pace_slice < PACE_SLICE_MAX) {
+        ctx->pace_slice *= 2;
+    } else if (slice_ns > PACE_SLICE_NS * 2 && ctx->pace_slice > 1) {
+        ctx->pace_slice /= 2;
+    }
+
+    /* Oversleeping is made up for by the next slices */
+    const uint64_t now    = clock_ns(CLOCK_MONOTONIC);
+    const uint64_t target = wall_begin + (cpu - cpu_begin) / pace->share;
+    if (target > now) {
+        const struct timespec ts = {
+            .tv_sec  = (target - now) / 1000000000,
+            .tv_nsec = (target - now) % 1000000000,
+        };
+        nanosleep(&ts, NULL);
+        pace->sleep_ns += clock_ns(CLOCK_MONOTONIC) - now;
+    }
+
+    return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/* Times of a paced scan (see `zps_pace()`) */
+struct scan_times {
+    uint64_t cpu_begin;
+    uint64_t wall_begin;
+    uint64_t slice_begin;
+};
+
+/*!
+ * Read the entries of `/proc` and call `cb` for each process matching the
+ * filter, specialized by the filter.
+ *
+ * This is instantiated by `SCAN_DIR()` with constant arguments for the
+ * common filters, so the per-process path of a scan that is neither
+ * measured nor paced only does what its filter needs.
+ *
+ * @param[in,out] ctx          Pointer to the context
+ * @param[in]     filter       Pointer to the filter (for the parent)
+ * @param[in]     cb           Function to call for every reported process
+ * @param[in]     userdata     Pointer to pass to `cb`
+ * @param[in,out] times        Pointer to the times of a paced scan
+ * @param[in]     zombies_only Boolean value for only reporting zombies
+ * @param[in]     state_only   Boolean value for only reading the states
+ * @param[in]     skip_cmd     Boolean value for not reading command lines
+ * @param[in]     timed        Boolean value for a measured or paced scan
+ *
+ * @return `-1` if the processes could not be enumerated, otherwise `0` is
+ *         returned
+ */
+static inline __attribute__((always_inline)) int
+scan_dir(struct zps_ctx *ctx, const struct zps_filter *filter, zps_scan_cb cb,
+         void *userdata, struct scan_times *times, const bool zombies_only,
+         const bool state_only, const bool skip_cmd, const bool timed)
+{
+    struct zps_perf *const perf = timed ? ctx->perf : NULL;
+    struct zps_pace *const pace = timed ? ctx->pace : NULL;
+    const int fd                = ctx->dirfd;
+    size_t slice                = 0;
+
+    /* Read the entries directly, so that every syscall is measured */
+    uint64_t dents[DENTS_BUF_SIZE / sizeof(uint64_t)];
+    for (ssize_t pos = 0, len = 0;;) {
+        if (pos == len) {
+            const uint64_t begin = zps_perf_begin(perf);
+            len = syscall(SYS_getdents64, fd, dents, sizeof(dents));
+            zps_perf_end(perf, ZPS_PHASE_ENUMERATE, begin);
+            if (perf) {
+                ++perf->syscalls;
+            }
+            if (len <= 0) {
+                return len ? -1 : 0;
+            }
+            pos = 0;
+        }
+        const struct linux_dirent64 *const d =
+            (const struct linux_dirent64 *)((const char *)dents + pos);
+        pos += d->d_reclen;
+        if (!(d->d_type == DT_DIR && isdigit(d->d_name[0]))) {
+            continue;
+        }
+        if (pace && ++slice >= ctx->pace_slice) {
+            times->slice_begin = zps_pace(ctx, times->cpu_begin,
+                                          times->wall_begin,
+                                          times->slice_begin);
+            slice              = 0;
+        }
+
+        struct zps_proc proc_stats = {0};
+        if (state_only ? zps_get_proc_state(fd, d->d_name, &proc_stats, perf)
+                       : zps_get_proc_stats(fd, d->d_name, &proc_stats, perf)) {
+            continue;
+        }
+        const uint64_t begin = timed ? zps_perf_begin(perf) : 0;
+        const bool rejected  =
+            (zombies_only && proc_stats.state != ZPS_STATE_ZOMBIE) ||
+            (filter->ppid && proc_stats.ppid != filter->ppid);
+        if (timed) {
+            zps_perf_end(perf, ZPS_PHASE_FILTER, begin);
+        }
+        if (rejected) {
+            continue;
+        }
+        if (skip_cmd || state_only) {
+            ctx->cmd_buf[0] = '\0';
+            proc_stats.cmd  = ctx->cmd_buf;
+        } else if (zps_get_proc_cmd(fd, d->d_name, &proc_stats, ctx->cmd_buf,
+                                    ctx->cmd_bufsiz, perf)) {
+            continue;
+        }
+        if (cb(&proc_stats, userdata)) {
+            return 0;
+        }
+    }
+}
+
+/* Type of the `scan_dir()` instances */
+typedef int (*scan_dir_fn)(struct zps_ctx *ctx, const struct zps_filter *filter,
+                           zps_scan_cb cb, void *userdata,
+                           struct scan_times *times);
+
+/* Defines a `scan_dir()` instance for a filter of an untimed scan */
+#define SCAN_DIR(name, zombies_only, state_only, skip_cmd)                    \
+    static int name(struct zps_ctx *ctx, const struct zps_filter *filter,     \
+                    zps_scan_cb cb, void *userdata, struct scan_times *times) \
+    {                                                                         \
+        return scan_dir(ctx, filter, cb, userdata, times, zombies_only,       \
+                        state_only, skip_cmd, false);                         \
+    }
+
+SCAN_DIR(scan_dir_zombie_states, true, true, true)
+SCAN_DIR(scan_dir_zombies, true, false, false)
+SCAN_DIR(scan_dir_zombies_no_cmd, true, false, true)
+SCAN_DIR(scan_dir_all, false, false, false)
+SCAN_DIR(scan_dir_all_no_cmd, false, false, true)
+
+/*!
+ * Read the entries of `/proc` with any filter, measured or paced as set up
+ * in the context.
+ *
+ * @see scan_dir()
+ */
+static int scan_dir_any(struct zps_ctx *ctx, const struct zps_filter *filter,
+                        zps_scan_cb cb, void *userdata,
+                        struct scan_times *times)
+{
+    return scan_dir(ctx, filter, cb, userdata, times, filter->zombies_only,
+                    filter->state_only, filter->skip_cmd, true);
+}
+
+/*!
+ * Select the `scan_dir()` instance for the filter and the context.
+ *
+ * @param[in] ctx    Pointer to the context (measured? paced?)
+ * @param[in] filter Pointer to the filter
+ *
+ * @return Instance to read the entries with
+ */
+static scan_dir_fn scan_dir_select(const struct zps_ctx *ctx,
+                                   const struct zps_filter *filter)
+{
+    if (ctx->perf || ctx->pace) {
+        return scan_dir_any;
+    }
+    if (filter->state_only) {
+        return filter->zombies_only ? scan_dir_zombie_states : scan_dir_any;
+    }
+    if (filter->zombies_only) {
+        return filter->skip_cmd ? scan_dir_zombies_no_cmd : scan_dir_zombies;
+    }
+    return filter->skip_cmd ? scan_dir_all_no_cmd : scan_dir_all;
+}
+
+/*!
+ * Scan the processes and call `cb` for each one matching the filter.
+ *
+ * Kernel threads are never reported. The command line is only read for the
+ * matching processes. Zombies are found with the task iterator if enabled,
+ * falling back to `/proc` if it fails.
+ *
+ * @param[in,out] ctx      Pointer to the context, `NULL` to scan `/proc`
+ *                         with a temporary one (which allocates)
+ * @param[in]     filter   Pointer to the filter, `NULL` to report every
+ *                         process
+ * @param[in]     cb       Function to call for every reported process
+ * @param[in]     userdata Pointer to pass to `cb`
+ *
+ * @return `-1` if the processes could not be enumerated (with `errno` set,
+ *         the reported processes may be incomplete), otherwise `0` is
+ *         returned
+ */
+int zps_scan(struct zps_ctx *ctx, const struct zps_filter *filter,
+             zps_scan_cb cb, void *userdata)
+{
+    static const struct zps_filter filter_all = {0};
+
+    assert(cb);
+
+    if (!ctx) {
+        struct zps_ctx *const tmp_ctx =
+            zps_ctx_new(ZPS_PROC_FILESYSTEM, ZPS_CMD_MAX_LEN);
+        if (!tmp_ctx) {
+            return -1;
+        }
+        const int rc  = zps_scan(tmp_ctx, filter, cb, userdata);
+        const int err = errno;
+        zps_ctx_free(tmp_ctx);
+        errno = err;
+        return rc;
+    }
+    if (!filter) {
+        filter = &filter_all;
+    }
+    struct zps_perf *const perf = ctx->perf;
+    struct zps_pace *const pace = ctx->pace;
+    struct scan_times times     = {0};
+    if (pace) {
+        pace->sleep_ns    = 0;
+        times.cpu_begin   = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+        times.slice_begin = times.cpu_begin;
+        times.wall_begin  = clock_ns(CLOCK_MONOTONIC);
+    }
+    /* The task iterator finds the zombies in a single pass (and `/proc` is
+     * only read if it cannot be started) */
+    int bpf_rc = -1;
+    if (ctx->bpf && filter->zombies_only) {
+        bpf_rc = zps_bpf_scan(ctx->bpf, ctx, filter, cb, userdata);
+    }
+    int rc = bpf_rc == 1 ? -1 : 0;
+    if (bpf_rc == -1) {
+        rc = lseek(ctx->dirfd, 0, SEEK_SET) == -1 ? -1 : 0;
+        if (perf) {
+            ++perf->syscalls;
+        }
+        if (!rc) {
+            /* The filter and the timing are only tested once per scan */
+            rc = scan_dir_select(ctx, filter)(ctx, filter, cb, userdata,
+                                              &times);
+        }
+    }
+    const int err = errno;
+    if (pace) {
+        /* Rest after the last slice as well (e.g. between watched scans) */
+        zps_pace(ctx, times.cpu_begin, times.wall_begin, times.slice_begin);
+        pace->cpu_ns  = clock_ns(CLOCK_THREAD_CPUTIME_ID) - times.cpu_begin;
+        pace->wall_ns = clock_ns(CLOCK_MONOTONIC) - times.wall_begin;
+    }
+    errno = err;
+
+    return rc;
+}
+
+/*!
+ * Read the stats and the command line of a single process.
+ *
+ * @param[in,out] ctx        Pointer to the context
+ * @param[in]     pid        PID of the process
+ * @param[out]    proc_stats Pointer to the struct to write to (`cmd` points
+ *                           into the context until the next call)
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+int zps_lookup(struct zps_ctx *ctx, pid_t pid, struct zps_proc *proc_stats)
+{
+    char pid_buf[32] = {0};
+
+    assert(ctx);
+    assert(proc_stats);
+
+    snprintf(pid_buf, sizeof(pid_buf), "%d", pid);
+    if (zps_get_proc_stats(ctx->dirfd, pid_buf, proc_stats, NULL) ||
+        zps_get_proc_cmd(ctx->dirfd, pid_buf, proc_stats, ctx->cmd_buf,
+                         ctx->cmd_bufsiz, NULL)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Send a signal to the parent of a zombie, refusing `init` and `kthreadd`.
+ *
+ * @param[in] ppid PID of the parent
+ * @param[in] sig  Signal to send
+ *
+ * @return `-1` on error (with `errno` set, `EPERM` for `init` and
+ *         `kthreadd`), otherwise `0` is returned
+ */
+int zps_signal_parent(pid_t ppid, int sig)
+{
+    if (ppid <= 0 || ppid == ZPS_INIT_PID || ppid == ZPS_KTHREADD_PID) {
+        errno = EPERM;
+        return -1;
+    }
+    return kill(ppid, sig);
+}
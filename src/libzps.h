@@ -0,0 +1,147 @@
+/**!
+ * libzps, the process scanner of zps as a library.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBZPS_H
+#define LIBZPS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Marks the functions exported by the library (the internals are hidden) */
+#if defined(__GNUC__) && !defined(ZPS_API)
+#define ZPS_API __attribute__((visibility("default")))
+#elif !defined(ZPS_API)
+#define ZPS_API
+#endif
+
+/* PID of `init` */
+#define ZPS_INIT_PID 1
+/* PID of `kthreadd` */
+#define ZPS_KTHREADD_PID 2
+
+/* Maximum length of userland process names (incl. '\0') */
+#define ZPS_TASK_COMM_LEN 16
+/* Maximum length the cmdline string can be truncated to (excl. '\0') */
+#define ZPS_CMD_MAX_LEN 4096
+
+/* `/proc` filesystem */
+#define ZPS_PROC_FILESYSTEM "/proc"
+
+/* Status file entry of zombie state */
+#define ZPS_STATE_ZOMBIE 'Z'
+
+/* Enum for the phases of a scan measured by `--stats` */
+enum zps_phase {
+    ZPS_PHASE_ENUMERATE = 0,
+    ZPS_PHASE_OPEN,
+    ZPS_PHASE_READ,
+    ZPS_PHASE_PARSE,
+    ZPS_PHASE_FILTER,
+    ZPS_PHASE_OUTPUT,
+    ZPS_PHASE_SIGNAL,
+    ZPS_PHASE_COUNT,
+};
+
+/* Struct for measuring the phases of a scan (`--stats`) */
+struct zps_perf {
+    /* Monotonic time spent in each phase (in nanoseconds) */
+    uint64_t phase_ns[ZPS_PHASE_COUNT];
+    /* Number of times each phase was entered */
+    size_t phase_calls[ZPS_PHASE_COUNT];
+    /* Number of syscalls issued (`getdents64()`, `lseek()`, `open()`,
+     * `read()`, `close()` and `kill()`, incl. the failed ones) */
+    size_t syscalls;
+    /* Number of bytes read from `/proc` */
+    size_t bytes_read;
+    /* Number of skipped kernel threads */
+    size_t kthreads;
+    /* Number of processes that vanished while being read */
+    size_t vanished;
+};
+
+/* Struct for pacing the scans to a share of a CPU (`--budget`) */
+struct zps_pace {
+    /* CPU time a scan may use per elapsed time, in the range of (0, 1] */
+    double share;
+    /* CPU time, elapsed time and time slept during the last scan (in ns) */
+    uint64_t cpu_ns;
+    uint64_t wall_ns;
+    uint64_t sleep_ns;
+};
+
+/* Struct for storing process stats */
+struct zps_proc {
+    pid_t pid;
+    pid_t ppid;
+    char state;
+    char padding[7];
+    /* Start time in clock ticks after boot (only parsed for zombies) */
+    unsigned long long starttime;
+    char name[ZPS_TASK_COMM_LEN];
+    /* Command line in the buffer passed to `zps_get_proc_cmd()` */
+    char *cmd;
+};
+
+/* Struct for selecting the processes reported by `zps_scan()` */
+struct zps_filter {
+    /* Boolean value for only reporting zombie processes */
+    bool zombies_only;
+    /* Boolean value for not reading the command lines (`cmd` is empty) */
+    bool skip_cmd;
+    /* Boolean value for only reading the PID, state and parent of the
+     * processes (`name` and `starttime` are empty, implies `skip_cmd`) */
+    bool state_only;
+    /* Only report the children of this process (`0` for any) */
+    pid_t ppid;
+};
+
+/*
+ * Reusable scan context holding the open `/proc` directory and the buffers,
+ * so that repeated scans do not allocate. It is optional for `zps_scan()`.
+ */
+struct zps_ctx;
+
+/*
+ * Function called for every reported process. The process information
+ * (including `cmd`) is only valid during the call. A non-zero return value
+ * stops the scan.
+ */
+typedef int (*zps_scan_cb)(const struct zps_proc *proc_stats,
+                           void *userdata);
+
+ZPS_API struct zps_ctx *zps_ctx_new(const char *proc_root, size_t cmd_len);
+ZPS_API void zps_ctx_free(struct zps_ctx *ctx);
+ZPS_API void zps_ctx_set_perf(struct zps_ctx *ctx, struct zps_perf *perf);
+ZPS_API int zps_ctx_use_bpf(struct zps_ctx *ctx);
+ZPS_API void zps_ctx_set_pace(struct zps_ctx *ctx, struct zps_pace *pace);
+ZPS_API int zps_scan(struct zps_ctx *ctx, const struct zps_filter *filter,
+                     zps_scan_cb cb, void *userdata);
+ZPS_API int zps_lookup(struct zps_ctx *ctx, pid_t pid,
+                       struct zps_proc *proc_stats);
+ZPS_API int zps_signal_parent(pid_t ppid, int sig);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBZPS_H
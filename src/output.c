@@ -0,0 +1,133 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "zps.h"
+
+/*!
+ * Write colored and formatted text to the specified stream.
+ *
+ * Resets the display attributes before returning
+ *
+ * @param[in]  color         ANSI SGR control sequence parameter n (color code)
+ * @param[in]  color_allowed Boolean specifying whether we can print color
+ * @param[out] stream        Pointer to the file to write to
+ * @param[in]  format        Format string specifying the text to print
+ * @param[in]  ...           Variable format string arguments
+ *
+ * @return void
+ */
+void cfprintf(enum ansi_fg_color_code color, bool color_allowed,
+              FILE *stream, const char *format, ...)
+{
+    va_list vargs;
+
+    assert(stream);
+    assert(format);
+
+    if (color_allowed) {
+        fprintf(stream, "\x1b[%dm", color);
+    }
+    va_start(vargs, format);
+    vfprintf(stream, format, vargs);
+    va_end(vargs);
+    if (color_allowed) {
+        fprintf(stream, "\x1b[%dm", ANSI_FG_NORMAL);
+    }
+}
+
+/*!
+ * Write bold, colored and formatted text to the specified stream.
+ *
+ * Resets the display attributes before returning
+ *
+ * @param[in]  color         ANSI SGR control sequence parameter n (color code)
+ * @param[in]  color_allowed Boolean specifying whether we can print color
+ * @param[out] stream        Pointer to the file to write to
+ * @param[in]  format        Format string specifying the text to print
+ * @param[in]  ...           Variable format string arguments
+ *
+ * @return void
+ */
+void cbfprintf(enum ansi_fg_color_code color, bool color_allowed,
+               FILE *stream, const char *format, ...)
+{
+    va_list vargs;
+
+    assert(stream);
+    assert(format);
+
+    if (color_allowed) {
+        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_BOLD);
+        if (color) {
+            fprintf(stream, "\x1b[%dm", color);
+        }
+    }
+    va_start(vargs, format);
+    vfprintf(stream, format, vargs);
+    va_end(vargs);
+    if (color_allowed) {
+        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_NORMAL);
+    }
+}
+
+/*!
+ * Write bold, colored and formatted text to the specified stream.
+ *
+ * Encloses the bold and colored text.
+ *
+ * @param[in]  color         ANSI SGR control sequence parameter n (color code)
+ * @param[in]  color_allowed Boolean specifying whether we can print color
+ * @param[in]  before        String to put before the colored content
+ * @param[in]  after         String to put after the colored content
+ * @param[out] stream        Pointer to the file to write to
+ * @param[in]  format        Format string specifying the text to print
+ * @param[in]  ...           Variable format string arguments
+ *
+ * @return void
+ */
+void cbfprintf_enclosed(enum ansi_fg_color_code color,
+                        bool color_allowed, const char *before,
+                        const char *after, FILE *stream,
+                        const char *format, ...)
+{
+    va_list vargs;
+
+    assert(before);
+    assert(after);
+    assert(stream);
+    assert(format);
+
+    fprintf(stream, "%s", before);
+    if (color_allowed) {
+        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_BOLD);
+        if (color) {
+            fprintf(stream, "\x1b[%dm", color);
+        }
+    }
+    va_start(vargs, format);
+    vfprintf(stream, format, vargs);
+    va_end(vargs);
+    if (color_allowed) {
+        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_NORMAL);
+    }
+    fprintf(stream, "%s", after);
+}
@@ -0,0 +1,451 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "zps.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX MAX_BUF_SIZE
+#endif
+
+/*!
+ * Split the next token off a policy line.
+ *
+ * Tokens are separated by whitespace and may be enclosed in double quotes
+ * to contain whitespace themselves.
+ *
+ * @param[in,out] cursor Pointer to the rest of the line, advanced past the
+ *                       token (the line gets modified)
+ *
+ * @return Null-terminated token, `NULL` at the end of the line
+ */
+static char *policy_token(char **cursor)
+{
+    char *begin = *cursor;
+    while (isspace((unsigned char)*begin)) {
+        ++begin;
+    }
+    if (!*begin) {
+        *cursor = begin;
+        return NULL;
+    }
+
+    char *end = begin;
+    if (*begin == '"') {
+        end = ++begin;
+        while (*end && *end != '"') {
+            ++end;
+        }
+    } else {
+        while (*end && !isspace((unsigned char)*end)) {
+            ++end;
+        }
+    }
+    *cursor = *end ? end + 1 : end;
+    *end    = '\0';
+
+    return begin;
+}
+
+/*!
+ * Copy the matched value into the rule.
+ *
+ * @param[out] rule  Pointer to the rule to update
+ * @param[in]  value Null-terminated name, executable path or cgroup
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int policy_rule_key(struct policy_rule *rule, const char *value)
+{
+    if (rule->type == POLICY_KEY_UID) {
+        return 0;
+    }
+    /* Process names are truncated by the kernel */
+    rule->key = strndup(value, rule->type == POLICY_KEY_NAME
+                                   ? ZPS_TASK_COMM_LEN - 1
+                                   : strlen(value));
+    return rule->key ? 0 : -1;
+}
+
+/*!
+ * Parse a line of a policy file into a rule.
+ *
+ * @param[in,out] buf  Null-terminated line (gets modified)
+ * @param[out]    rule Pointer to the rule to fill
+ *
+ * @return `-1` on error, `1` if the line is empty or a comment, otherwise
+ *         `0` is returned
+ */
+static int policy_parse_rule(char *buf, struct policy_rule *rule)
+{
+    char *cursor           = buf;
+    const char *const type = policy_token(&cursor);
+    if (!type || type[0] == '#') {
+        return 1;
+    }
+    const char *const value  = policy_token(&cursor);
+    const char *const action = policy_token(&cursor);
+    char *const args         = policy_token(&cursor);
+    if (!value || !*value || !action || policy_token(&cursor)) {
+        return -1;
+    }
+
+    if (!strcmp(type, "name")) {
+        rule->type = POLICY_KEY_NAME;
+    } else if (!strcmp(type, "exe")) {
+        rule->type = POLICY_KEY_EXE;
+    } else if (!strcmp(type, "cgroup")) {
+        rule->type = POLICY_KEY_CGROUP;
+    } else if (!strcmp(type, "uid")) {
+        char *end             = NULL;
+        const unsigned long n = strtoul(value, &end, 10);
+        if (!isdigit((unsigned char)*value) || *end || n >= INT_MAX) {
+            return -1;
+        }
+        rule->type = POLICY_KEY_UID;
+        rule->uid  = (uid_t)n;
+    } else {
+        return -1;
+    }
+
+    if (!strcmp(action, "ignore")) {
+        rule->action = POLICY_IGNORE;
+        return args ? -1 : policy_rule_key(rule, value);
+    } else if (!strcmp(action, "signal")) {
+        rule->action = POLICY_SIGNAL;
+    } else if (!strcmp(action, "escalate")) {
+        rule->action = POLICY_ESCALATE;
+    } else {
+        return -1;
+    }
+    if (!args) {
+        return -1;
+    }
+    char *save = NULL;
+    for (const char *sig_str = strtok_r(args, ",", &save); sig_str;
+         sig_str            = strtok_r(NULL, ",", &save)) {
+        const int sig = zps_user_signal(sig_str);
+        if (sig <= 0 || rule->signals_sz == POLICY_MAX_SIGNALS ||
+            (rule->action == POLICY_SIGNAL && rule->signals_sz)) {
+            return -1;
+        }
+        rule->signals[rule->signals_sz++] = sig;
+    }
+
+    if (!rule->signals_sz) {
+        return -1;
+    }
+    return policy_rule_key(rule, value);
+}
+
+/*!
+ * Build the hash tables of the loaded rules.
+ *
+ * @param[in,out] policy Pointer to the policy with its rules loaded
+ * @param[out]    line   Line of the duplicate rule on error
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int policy_compile(struct policy *policy, size_t *line)
+{
+    size_t counts[POLICY_KEY_UID + 1] = {0};
+    for (size_t i = 0; i < policy->rules_sz; ++i) {
+        ++counts[policy->rules[i].type];
+    }
+    if ((counts[POLICY_KEY_NAME] &&
+         !(policy->names = str_map(counts[POLICY_KEY_NAME]))) ||
+        (counts[POLICY_KEY_EXE] &&
+         !(policy->exes = str_map(counts[POLICY_KEY_EXE]))) ||
+        (counts[POLICY_KEY_CGROUP] &&
+         !(policy->cgroups = str_map(counts[POLICY_KEY_CGROUP]))) ||
+        (counts[POLICY_KEY_UID] &&
+         !(policy->uids = pid_map(counts[POLICY_KEY_UID])))) {
+        *line = 0;
+        return -1;
+    }
+
+    for (size_t i = 0; i < policy->rules_sz; ++i) {
+        const struct policy_rule *const rule = &policy->rules[i];
+        struct str_map *const map =
+            rule->type == POLICY_KEY_NAME  ? policy->names
+            : rule->type == POLICY_KEY_EXE ? policy->exes
+                                           : policy->cgroups;
+        *line = rule->line;
+        if (rule->type == POLICY_KEY_UID) {
+            /* PID maps cannot hold `0` (root) */
+            if (pid_map_find(policy->uids, rule->uid + 1) ||
+                !pid_map_put(policy->uids, rule->uid + 1, i)) {
+                return -1;
+            }
+        } else if (str_map_find(map, rule->key) ||
+                   !str_map_put(map, rule->key, i)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * Load and compile a policy file.
+ *
+ * Each line of the file is a rule in the form of `<type> <value> <action>`
+ * where the type is one of `name`, `exe`, `cgroup` and `uid` and the action
+ * is one of `ignore`, `signal <sig>` and `escalate <sig>,<sig>,...`.
+ *
+ * The `policy_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @param[in]  path      Path of the policy file
+ * @param[in]  proc_root Path of the `/proc` filesystem
+ * @param[out] line      Line of the invalid rule on error (`0` if the error
+ *                       is not related to a line)
+ *
+ * @return Pointer to the loaded policy, `NULL` on error
+ */
+struct policy *policy_load(const char *path, const char *proc_root,
+                           size_t *line)
+{
+    assert(path);
+    assert(proc_root);
+    assert(line);
+
+    char *buf          = NULL;
+    size_t bufsiz      = 0;
+    size_t max_sz      = 0;
+    *line              = 0;
+    FILE *const file   = fopen(path, "r");
+    struct policy *pol = calloc(1, sizeof(*pol));
+    if (pol) {
+        pol->dirfd = -1;
+    }
+    if (!file || !pol) {
+        goto fail;
+    }
+    pol->dirfd = open(proc_root, O_RDONLY | O_DIRECTORY);
+    pol->index = pid_map(POLICY_STATE_SIZE);
+    if (pol->dirfd == -1 || !pol->index) {
+        goto fail;
+    }
+
+    for (size_t n = 1; getline(&buf, &bufsiz, file) != -1; ++n) {
+        struct policy_rule rule = {.line = n};
+        const int rc            = policy_parse_rule(buf, &rule);
+        if (rc == 1) {
+            continue;
+        }
+        *line = n;
+        if (rc) {
+            free(rule.key);
+            goto fail;
+        }
+        if (pol->rules_sz == max_sz) {
+            max_sz = max_sz ? max_sz * 2 : 16;
+            struct policy_rule *const rules =
+                realloc(pol->rules, max_sz * sizeof(*rules));
+            if (!rules) {
+                free(rule.key);
+                goto fail;
+            }
+            pol->rules = rules;
+        }
+        pol->rules[pol->rules_sz++] = rule;
+    }
+    if (policy_compile(pol, line)) {
+        goto fail;
+    }
+    free(buf);
+    fclose(file);
+    *line = 0;
+
+    return pol;
+
+fail:
+    free(buf);
+    if (file) {
+        fclose(file);
+    }
+    policy_free(pol);
+    return NULL;
+}
+
+/*!
+ * Frees and invalidates the policy pointed to by the `policy`.
+ *
+ * @param[out] policy Policy to deallocate, may be `NULL`
+ *
+ * @return void
+ */
+void policy_free(struct policy *policy)
+{
+    if (!policy) {
+        return;
+    }
+    for (size_t i = 0; i < policy->rules_sz; ++i) {
+        free(policy->rules[i].key);
+    }
+    free(policy->rules);
+    str_map_free(policy->names);
+    str_map_free(policy->exes);
+    str_map_free(policy->cgroups);
+    pid_map_free(policy->uids);
+    pid_map_free(policy->index);
+    if (policy->dirfd != -1) {
+        close(policy->dirfd);
+    }
+    free(policy);
+}
+
+/*!
+ * Start a new scan: the cached decisions are matched again once and the
+ * escalating rules advance for the parents that still have zombies.
+ *
+ * @param[out] policy Policy to update
+ *
+ * @return void
+ */
+void policy_next_scan(struct policy *policy)
+{
+    assert(policy);
+
+    ++policy->generation;
+}
+
+/*!
+ * Find the rule matching a parent process.
+ *
+ * The attributes are checked from the most to the least specific one:
+ * executable, name, cgroup and UID. Only the attributes that have rules
+ * are read.
+ *
+ * @param[in] policy Policy to use
+ * @param[in] ppid   PID of the parent
+ *
+ * @return Pointer to the matching rule, `NULL` if none
+ */
+static const struct policy_rule *policy_match(const struct policy *policy,
+                                              pid_t ppid)
+{
+    char pid_buf[32] = {0}, buf[PATH_MAX] = {0};
+    const size_t *index = NULL;
+
+    snprintf(pid_buf, sizeof(pid_buf), "%d", ppid);
+    if (policy->exes) {
+        char path[64] = {0};
+        snprintf(path, sizeof(path), "%s/exe", pid_buf);
+        const ssize_t len =
+            readlinkat(policy->dirfd, path, buf, sizeof(buf) - 1);
+        if (len > 0) {
+            buf[len] = '\0';
+            index    = str_map_find(policy->exes, buf);
+        }
+    }
+    if (!index && policy->names) {
+        struct zps_proc proc_stats = {0};
+        if (!zps_get_proc_stats(policy->dirfd, pid_buf, &proc_stats, NULL)) {
+            index = str_map_find(policy->names, proc_stats.name);
+        }
+    }
+    if (!index && policy->cgroups &&
+        zps_read_file(policy->dirfd, buf, sizeof(buf), NULL, "%s/cgroup",
+                      pid_buf) > 0) {
+        /* Lines are in the form of `<id>:<controllers>:<path>` */
+        char *save = NULL;
+        for (char *l = strtok_r(buf, "\n", &save); l && !index;
+             l       = strtok_r(NULL, "\n", &save)) {
+            const char *path = strchr(l, ':');
+            if (path && (path = strchr(path + 1, ':'))) {
+                index = str_map_find(policy->cgroups, path + 1);
+            }
+        }
+    }
+    if (!index && policy->uids) {
+        struct stat st = {0};
+        if (!fstatat(policy->dirfd, pid_buf, &st, 0) && st.st_uid < INT_MAX) {
+            index = pid_map_find(policy->uids, st.st_uid + 1);
+        }
+    }
+
+    return index ? &policy->rules[*index] : NULL;
+}
+
+/*!
+ * Decide which signal to send to a parent process.
+ *
+ * The decision is matched once per parent and scan. An escalating rule uses
+ * its next signal if the parent had zombies in the previous scan as well.
+ *
+ * @param[in,out] policy Policy to use
+ * @param[in]     ppid   PID of the parent (must be positive)
+ * @param[in]     sig    Signal to use if no rule matches
+ *
+ * @return Signal to send, `0` if the parent should not be signaled
+ */
+int policy_signal(struct policy *policy, pid_t ppid, int sig)
+{
+    assert(policy);
+    assert(ppid > 0);
+
+    const size_t *const index   = pid_map_find(policy->index, ppid);
+    struct policy_state *state = index ? &policy->states[*index] : NULL;
+    if (!state || state->generation != policy->generation) {
+        const struct policy_rule *const rule = policy_match(policy, ppid);
+        const bool consecutive = state && state->rule == rule &&
+                                 state->generation + 1 == policy->generation;
+        if (!state) {
+            /* Start over once too many parents were seen */
+            if (policy->states_sz == POLICY_STATE_SIZE) {
+                pid_map_clear(policy->index);
+                policy->states_sz = 0;
+            }
+            state = &policy->states[policy->states_sz];
+            pid_map_put(policy->index, ppid, policy->states_sz++);
+        }
+        /* Only escalating rules advance (no rule may match twice) */
+        if (!consecutive || !rule || rule->action != POLICY_ESCALATE) {
+            state->level = 0;
+        } else if (state->level + 1 < rule->signals_sz) {
+            ++state->level;
+        }
+        state->ppid       = ppid;
+        state->rule       = rule;
+        state->generation = policy->generation;
+    }
+
+    if (!state->rule) {
+        return sig;
+    }
+    switch (state->rule->action) {
+    case POLICY_IGNORE:
+        return 0;
+    case POLICY_ESCALATE:
+        return state->rule->signals[state->level];
+    default:
+        return state->rule->signals[0];
+    }
+}
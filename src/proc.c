@@ -0,0 +1,397 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "zps.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX MAX_BUF_SIZE
+#endif
+
+/*!
+ * Returns the current time of the monotonic clock.
+ *
+ * @return Time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*!
+ * Start measuring a phase.
+ *
+ * @param[in] perf Pointer to the measurements, `NULL` if disabled
+ *
+ * @return Start time to pass to `zps_perf_end()`
+ */
+uint64_t zps_perf_begin(const struct zps_perf *perf)
+{
+    return perf ? now_ns() : 0;
+}
+
+/*!
+ * Finish measuring a phase.
+ *
+ * @param[out] perf  Pointer to the measurements, `NULL` if disabled
+ * @param[in]  phase Phase to account the time to
+ * @param[in]  begin Start time returned by `zps_perf_begin()`
+ *
+ * @return void
+ */
+void zps_perf_end(struct zps_perf *perf, enum zps_phase phase,
+                  uint64_t begin)
+{
+    if (perf) {
+        perf->phase_ns[phase] += now_ns() - begin;
+        ++perf->phase_calls[phase];
+    }
+}
+
+/*!
+ * Read the given file and return its content.
+ *
+ * @param[in]     dirfd  Directory to resolve relative paths against
+ *                       (`AT_FDCWD` for the working directory)
+ * @param[out]    buf    Buffer to read the null-terminated content into
+ * @param[in]     bufsiz Size of allocated `buf`
+ * @param[out]    perf   Pointer to the measurements, `NULL` if disabled
+ * @param[in]     format Format string specifying the file path
+ * @param[in]     ...    Variable format string arguments
+ *
+ * @return number of bytes successfully read (max: `bufsiz - 1`),
+           `-1` on error
+ */
+ssize_t zps_read_file(int dirfd, char *buf, size_t bufsiz,
+                      struct zps_perf *perf, const char *format, ...)
+{
+    va_list vargs;
+    char path[PATH_MAX] = {0};
+
+    assert(buf);
+    assert(bufsiz > 0);
+    assert(format);
+
+    va_start(vargs, format);
+    int num_required = vsnprintf(path, sizeof(path), format, vargs);
+    va_end(vargs);
+    /* Check for errors or truncation */
+    if (num_required < 0 || (size_t)num_required >= sizeof(path)) {
+        return -1;
+    }
+
+    uint64_t begin = zps_perf_begin(perf);
+    const int fd   = openat(dirfd, path, O_RDONLY);
+    zps_perf_end(perf, ZPS_PHASE_OPEN, begin);
+    if (perf) {
+        ++perf->syscalls;
+    }
+    if (fd == -1) {
+        if (perf && errno == ENOENT) {
+            ++perf->vanished;
+        }
+        return -1;
+    }
+    begin           = zps_perf_begin(perf);
+    ssize_t read_rc = read(fd, buf, bufsiz - 1);
+    zps_perf_end(perf, ZPS_PHASE_READ, begin);
+    close(fd);
+    /* Only terminate the read bytes, the rest of `buf` is left as is */
+    buf[read_rc > 0 ? read_rc : 0] = '\0';
+    if (perf) {
+        perf->syscalls += 2;
+        if (read_rc > 0) {
+            perf->bytes_read += read_rc;
+        } else if (read_rc == -1 && errno == ESRCH) {
+            ++perf->vanished;
+        }
+    }
+
+    return read_rc;
+}
+
+/*!
+ * Parse the start time out of the fields of `"/proc/<pid>/stat"`.
+ *
+ * @param[in]  fields    Null-terminated fields following `comm`, starting
+ *                       with the 3rd one (state)
+ * @param[out] starttime Pointer to write the start time (in clock ticks
+ *                       after system boot) to
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+int zps_parse_stat_starttime(const char *fields,
+                             unsigned long long *starttime)
+{
+    assert(fields);
+    assert(starttime);
+
+    /* Skip to the 22nd field (starttime) */
+    for (int i = 3; i < 22; ++i) {
+        fields = strchr(fields, ' ');
+        if (!fields) {
+            return -1;
+        }
+        ++fields;
+    }
+    if (sscanf(fields, "%llu", starttime) != 1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Parse the content of `"/proc/<pid>/stat"` into `proc_stats`.
+ *
+ * @param[in,out] stat_buf   Null-terminated buffer containing the contents of
+                             `"/proc/<pid>/stat"` from offset `0`; will be
+                             modified during execution
+ * @param[out]    proc_stats Pointer to write the process information to
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+int zps_parse_stat_content(char *stat_buf, struct zps_proc *proc_stats)
+{
+    assert(stat_buf);
+    assert(proc_stats);
+
+    /* Start with the PID field */
+    if (sscanf(stat_buf, "%d", &proc_stats->pid) != 1) {
+        return -1;
+    }
+
+    /* Pointer bounds for `comm` in the buffer */
+    const char *begin = strchr(stat_buf, '(');
+    if (!begin) {
+        return -1;
+    }
+    char *const end = strrchr(begin, ')');
+    if (!end || end[1] == '\0') {
+        return -1;
+    }
+    ++begin;
+    const char *const last_fields = end + 2;
+    /*
+        begin:
+            %d (...) %c %d
+                ^
+        end:
+            %d (...) %c %d
+                   ^
+        last_fields:
+            %d (...) %c %d
+                     ^
+    */
+    /* Extract the last fields first */
+    if (sscanf(last_fields, "%c %d", &proc_stats->state, &proc_stats->ppid) !=
+        2) {
+        return -1;
+    }
+
+    /* Zombies also need their start time */
+    if (proc_stats->state == ZPS_STATE_ZOMBIE &&
+        zps_parse_stat_starttime(last_fields, &proc_stats->starttime)) {
+        return -1;
+    }
+
+    /* Limit `comm_strlen` */
+    *end                     = '\0';
+    const size_t comm_strlen = strnlen(begin, sizeof(proc_stats->name) - 1);
+    /* Extract the process name (limited by `comm_strlen`) */
+    memcpy(proc_stats->name, begin, comm_strlen);
+    /* Make sure string ends here */
+    proc_stats->name[comm_strlen] = '\0';
+
+    return 0;
+}
+
+/*!
+ * Parse and return the stats for a given PID.
+ *
+ * @param[in]  dirfd      Open `/proc` directory
+ * @param[in]  pid        String containing the PID
+ * @param[out] proc_stats Pointer to the struct to write to (without `cmd`)
+ * @param[out] perf       Pointer to the measurements, `NULL` if disabled
+ *
+ * @return `-1` on error, `0` otherwise
+ */
+int zps_get_proc_stats(int dirfd, const char *pid, struct zps_proc *proc_stats,
+                       struct zps_perf *perf)
+{
+    char stat_buf[MAX_BUF_SIZE] = {0};
+
+    assert(pid);
+    assert(proc_stats);
+
+    /* Read the `"/proc/<pid>/stat"` file. */
+    if (zps_read_file(dirfd, stat_buf, sizeof(stat_buf), perf, "%s/%s", pid,
+                      STAT_FILE) == -1) {
+        return -1;
+    }
+    const uint64_t begin = zps_perf_begin(perf);
+    const int rc         = zps_parse_stat_content(stat_buf, proc_stats);
+    zps_perf_end(perf, ZPS_PHASE_PARSE, begin);
+    if (rc) {
+        return -1;
+    }
+    /* We do not want kernel processes/threads */
+    if (proc_stats->ppid == ZPS_KTHREADD_PID ||
+        proc_stats->pid == ZPS_KTHREADD_PID) {
+        if (perf) {
+            ++perf->kthreads;
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Parse the PID, state and parent for a given PID out of the beginning of
+ * its stat file only.
+ *
+ * Falls back to `zps_get_proc_stats()` if the fields do not fit into
+ * `STAT_PREFIX_SIZE` bytes (e.g. for long names).
+ *
+ * @param[in]  dirfd      Open `/proc` directory
+ * @param[in]  pid        String containing the PID
+ * @param[out] proc_stats Pointer to the struct to write to (without `name`,
+ *                        `starttime` and `cmd`)
+ * @param[out] perf       Pointer to the measurements, `NULL` if disabled
+ *
+ * @return `-1` on error, `0` otherwise
+ */
+int zps_get_proc_state(int dirfd, const char *pid, struct zps_proc *proc_stats,
+                       struct zps_perf *perf)
+{
+    char stat_buf[STAT_PREFIX_SIZE] = {0};
+    int ppid_end                    = 0;
+
+    assert(pid);
+    assert(proc_stats);
+
+    if (zps_read_file(dirfd, stat_buf, sizeof(stat_buf), perf, "%s/%s", pid,
+                      STAT_FILE) == -1) {
+        return -1;
+    }
+    const uint64_t begin = zps_perf_begin(perf);
+    /* Only numeric fields follow `comm`, so its last ')' closes it */
+    const char *const end = strrchr(stat_buf, ')');
+    /* The parent is complete if a field follows it */
+    const bool parsed =
+        sscanf(stat_buf, "%d", &proc_stats->pid) == 1 && end &&
+        sscanf(end, ") %c %d%n", &proc_stats->state, &proc_stats->ppid,
+               &ppid_end) == 2 &&
+        end[ppid_end] == ' ';
+    zps_perf_end(perf, ZPS_PHASE_PARSE, begin);
+    if (!parsed) {
+        return zps_get_proc_stats(dirfd, pid, proc_stats, perf);
+    }
+    /* We do not want kernel processes/threads */
+    if (proc_stats->ppid == ZPS_KTHREADD_PID ||
+        proc_stats->pid == ZPS_KTHREADD_PID) {
+        if (perf) {
+            ++perf->kthreads;
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Read the command line of the given PID.
+ *
+ * @param[in]  dirfd      Open `/proc` directory
+ * @param[in]  pid        String containing the PID
+ * @param[out] proc_stats Pointer to the struct whose `cmd` field will point
+ *                        to `cmd_buf`
+ * @param[out] cmd_buf    Buffer to read the command line into
+ * @param[in]  cmd_bufsiz Size of `cmd_buf` (limits the command length)
+ * @param[out] perf       Pointer to the measurements, `NULL` if disabled
+ *
+ * @return `-1` on error, `0` otherwise
+ */
+int zps_get_proc_cmd(int dirfd, const char *pid, struct zps_proc *proc_stats,
+                     char *cmd_buf, size_t cmd_bufsiz, struct zps_perf *perf)
+{
+    assert(pid);
+    assert(proc_stats);
+    assert(cmd_buf);
+
+    /* Read the `"/proc/<pid>/cmdline"` file */
+    proc_stats->cmd       = cmd_buf;
+    const ssize_t cmd_len = zps_read_file(dirfd, cmd_buf, cmd_bufsiz, perf,
+                                          "%s/%s", pid, CMD_FILE);
+    if (cmd_len == -1) {
+        return -1;
+    }
+
+    /* Replace any null bytes with spaces to also print further arguments */
+    const uint64_t begin = zps_perf_begin(perf);
+    for (size_t i = 0; i < (size_t)cmd_len; ++i) {
+        if (!proc_stats->cmd[i]) {
+            proc_stats->cmd[i] = ' ';
+        }
+    }
+    zps_perf_end(perf, ZPS_PHASE_PARSE, begin);
+
+    return 0;
+}
+
+/*!
+ * Read the start time of the process with the given PID.
+ *
+ * @param[in]  dirfd     Open `/proc` directory
+ * @param[in]  pid       PID of the process
+ * @param[out] starttime Pointer to write the start time (in clock ticks
+ *                       after system boot) to
+ *
+ * @return `-1` on error, `0` otherwise
+ */
+int zps_get_proc_starttime(int dirfd, pid_t pid, unsigned long long *starttime)
+{
+    char stat_buf[MAX_BUF_SIZE] = {0};
+
+    assert(starttime);
+
+    if (zps_read_file(dirfd, stat_buf, sizeof(stat_buf), NULL, "%d/%s", pid,
+                      STAT_FILE) == -1) {
+        return -1;
+    }
+    /* Fields after `comm` start with the 3rd one (state) */
+    const char *const end = strrchr(stat_buf, ')');
+    if (!end || end[1] == '\0') {
+        return -1;
+    }
+
+    return zps_parse_stat_starttime(end + 2, starttime);
+}
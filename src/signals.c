@@ -0,0 +1,108 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <ctype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "zps.h"
+
+/* Array used for lookup of common signals' abbreviations */
+static const char *const abbrevs[NSIG] = {
+    [SIGHUP] = "HUP",       [SIGINT] = "INT",     [SIGQUIT] = "QUIT",
+    [SIGILL] = "ILL",       [SIGTRAP] = "TRAP",   [SIGABRT] = "ABRT",
+    [SIGFPE] = "FPE",       [SIGKILL] = "KILL",   [SIGBUS] = "BUS",
+    [SIGSYS] = "SYS",       [SIGSEGV] = "SEGV",   [SIGPIPE] = "PIPE",
+    [SIGALRM] = "ALRM",     [SIGTERM] = "TERM",   [SIGURG] = "URG",
+    [SIGSTOP] = "STOP",     [SIGTSTP] = "TSTP",   [SIGCONT] = "CONT",
+    [SIGCHLD] = "CHLD",     [SIGTTIN] = "TTIN",   [SIGTTOU] = "TTOU",
+    [SIGPOLL] = "POLL",     [SIGXCPU] = "XCPU",   [SIGXFSZ] = "XFSZ",
+    [SIGVTALRM] = "VTALRM", [SIGPROF] = "PROF",   [SIGUSR1] = "USR1",
+    [SIGUSR2] = "USR2",     [SIGWINCH] = "WINCH",
+};
+
+/*!
+ * Helper to get the string abbreviation of signal constants
+ *
+ * @param[in] sig Signal number to get the string representation of
+ *
+ * @return String representing the signal constant (abbreviated),
+ *         or NULL if no corresponding signal string was found
+ */
+const char *zps_sig_abbrev(int sig)
+{
+    if (sig < 0 || !((size_t)sig < sizeof(abbrevs))) {
+        return NULL;
+    }
+    return abbrevs[sig];
+}
+
+/*!
+ * Attempts to find the corresponding signal number to the
+ * given signal constant's name
+ *
+ * @param[in] sig_str Signal name to convert
+ *
+ * @return -1 on error, the corresponding signal number otherwise
+ */
+int zps_sig_str_to_num(const char *sig_str)
+{
+    assert(sig_str);
+
+    const char *const prefix = "SIG";
+    const size_t prefix_len  = strlen(prefix);
+    if (!strncasecmp(sig_str, prefix, prefix_len)) {
+        sig_str += prefix_len;
+    }
+
+    for (size_t sig = 0; sig < sizeof(abbrevs) / sizeof(abbrevs[0]); ++sig) {
+        if (!abbrevs[sig]) {
+            continue;
+        }
+        if (!strcasecmp(sig_str, abbrevs[sig])) {
+            return sig;
+        }
+    }
+    return -1;
+}
+
+/*!
+ * Tries to associate the user's signal input with a known
+ * signal number
+ *
+ * @param[in] sig_str Signal characters to convert
+ *
+ * @return -1 on error, the corresponding signal number otherwise
+ */
+int zps_user_signal(const char *sig_str)
+{
+    if (!sig_str) {
+        return -1;
+    }
+    if (!isdigit(*sig_str)) {
+        return zps_sig_str_to_num(sig_str);
+    }
+
+    int sig = -1;
+    if (sscanf(sig_str, "%d", &sig) != 1 || sig < 0 || NSIG <= sig) {
+        return -1;
+    }
+    return abbrevs[sig] ? sig : -1;
+}
@@ -0,0 +1,210 @@
+/**!
+ * zps, a small utility for listing and reaping zombie processes.
+ * Copyright © 2019-2024 by Orhun Parmaksız <orhunparmaksiz@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zps.h"
+
+/* Header of a chunk in the temporary file (followed by the entries and the
+ * arena) */
+struct spill_header {
+    size_t sz;
+    size_t arena_sz;
+};
+
+/*!
+ * Write the current chunk to the temporary file and empty it.
+ *
+ * @param[in,out] spill Pointer to the spill
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int proc_spill_write(struct proc_spill *spill)
+{
+    struct proc_vec *const chunk     = spill->chunk;
+    const struct spill_header header = {
+        .sz       = chunk->sz,
+        .arena_sz = chunk->arena_sz,
+    };
+
+    if ((!spill->file && !(spill->file = tmpfile())) ||
+        fwrite(&header, sizeof(header), 1, spill->file) != 1 ||
+        fwrite(chunk->ptr, sizeof(*chunk->ptr), chunk->sz, spill->file) !=
+            chunk->sz ||
+        fwrite(chunk->arena, 1, chunk->arena_sz, spill->file) !=
+            chunk->arena_sz) {
+        spill->failed = true;
+        return -1;
+    }
+    ++spill->chunks;
+    proc_vec_clear(chunk);
+
+    return 0;
+}
+
+/*!
+ * Constructs an empty spill for collecting the zombies.
+ *
+ * The `proc_spill_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @param[in] budget Memory budget (in bytes), `0` to grow without a limit
+ *
+ * @return Pointer to the allocated structure, `NULL` on error
+ */
+struct proc_spill *proc_spill(size_t budget)
+{
+    struct proc_spill *const spill = calloc(1, sizeof(*spill));
+    if (!spill) {
+        return NULL;
+    }
+
+    spill->budget = budget;
+    if (budget) {
+        /* Half of the budget for the entries and half for their strings */
+        spill->chunk =
+            proc_vec_sized(budget / 2 / sizeof(struct proc_entry) + 1,
+                           budget / 2 + 1);
+    } else {
+        spill->chunk = proc_vec();
+    }
+    if (!spill->chunk) {
+        free(spill);
+        return NULL;
+    }
+
+    return spill;
+}
+
+/*!
+ * Frees and invalidates the spill pointed to by `spill`.
+ *
+ * @param[out] spill Spill to deallocate, may be `NULL`
+ *
+ * @return void
+ */
+void proc_spill_free(struct proc_spill *spill)
+{
+    if (!spill) {
+        return;
+    }
+    if (spill->file) {
+        fclose(spill->file);
+    }
+    proc_vec_free(spill->chunk);
+    free(spill);
+}
+
+/*!
+ * Adds `entry` to the spill, writing the full chunk to the temporary file
+ * first if needed.
+ *
+ * @param[in,out] spill Spill to use
+ * @param[in]     entry Pointer to the entry to add
+ *
+ * @return `false` on error, `true` otherwise
+ */
+bool proc_spill_add(struct proc_spill *spill, const struct zps_proc *entry)
+{
+    assert(spill);
+    assert(entry);
+    assert(!spill->reading);
+
+    struct proc_vec *const chunk = spill->chunk;
+    if (spill->budget) {
+        const size_t len = strlen(entry->name) + 1 +
+                           (entry->cmd ? strlen(entry->cmd) + 1 : 0);
+        if ((chunk->sz == chunk->max_sz ||
+             chunk->arena_sz + len > chunk->arena_max_sz) &&
+            proc_spill_write(spill)) {
+            return false;
+        }
+        /* Never let the chunk grow past the budget */
+        if (chunk->arena_sz + len > chunk->arena_max_sz) {
+            return false;
+        }
+    }
+    return proc_vec_add(chunk, entry);
+}
+
+/*!
+ * Prepare reading the collected zombies from the beginning.
+ *
+ * The first call writes the remaining zombies to the temporary file (if it
+ * is used), after which no more zombies can be added.
+ *
+ * @param[in,out] spill Spill to use
+ *
+ * @return void
+ */
+void proc_spill_rewind(struct proc_spill *spill)
+{
+    assert(spill);
+
+    if (spill->file && !spill->reading && spill->chunk->sz) {
+        proc_spill_write(spill);
+    }
+    if (spill->file &&
+        (fflush(spill->file) || fseek(spill->file, 0, SEEK_SET))) {
+        spill->failed = true;
+    }
+    spill->reading = true;
+    spill->next    = 0;
+}
+
+/*!
+ * Returns the next chunk of the collected zombies.
+ *
+ * @param[in,out] spill Spill to use (see `proc_spill_rewind()`)
+ *
+ * @return Pointer to the chunk valid until the next call, `NULL` after the
+ *         last one or on error
+ */
+const struct proc_vec *proc_spill_next(struct proc_spill *spill)
+{
+    struct spill_header header = {0};
+
+    assert(spill);
+    assert(spill->reading);
+
+    if (!spill->file) {
+        return spill->next++ ? NULL : spill->chunk;
+    }
+    if (spill->next == spill->chunks) {
+        return NULL;
+    }
+    struct proc_vec *const chunk = spill->chunk;
+    if (fread(&header, sizeof(header), 1, spill->file) != 1 ||
+        header.sz > chunk->max_sz || header.arena_sz > chunk->arena_max_sz ||
+        fread(chunk->ptr, sizeof(*chunk->ptr), header.sz, spill->file) !=
+            header.sz ||
+        fread(chunk->arena, 1, header.arena_sz, spill->file) !=
+            header.arena_sz) {
+        spill->failed = true;
+        return NULL;
+    }
+    chunk->sz       = header.sz;
+    chunk->arena_sz = header.arena_sz;
+    ++spill->next;
+
+    return chunk;
+}
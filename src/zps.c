@@ -20,16 +20,26 @@
 #include <assert.h>
 #include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <limits.h>
+#include <math.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <termios.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -39,87 +49,77 @@
 #define PATH_MAX MAX_BUF_SIZE
 #endif
 
-/* Array used for lookup of common signals' abbreviations */
-static const char *const abbrevs[NSIG] = {
-    [SIGHUP] = "HUP",       [SIGINT] = "INT",     [SIGQUIT] = "QUIT",
-    [SIGILL] = "ILL",       [SIGTRAP] = "TRAP",   [SIGABRT] = "ABRT",
-    [SIGFPE] = "FPE",       [SIGKILL] = "KILL",   [SIGBUS] = "BUS",
-    [SIGSYS] = "SYS",       [SIGSEGV] = "SEGV",   [SIGPIPE] = "PIPE",
-    [SIGALRM] = "ALRM",     [SIGTERM] = "TERM",   [SIGURG] = "URG",
-    [SIGSTOP] = "STOP",     [SIGTSTP] = "TSTP",   [SIGCONT] = "CONT",
-    [SIGCHLD] = "CHLD",     [SIGTTIN] = "TTIN",   [SIGTTOU] = "TTOU",
-    [SIGPOLL] = "POLL",     [SIGXCPU] = "XCPU",   [SIGXFSZ] = "XFSZ",
-    [SIGVTALRM] = "VTALRM", [SIGPROF] = "PROF",   [SIGUSR1] = "USR1",
-    [SIGUSR2] = "USR2",     [SIGWINCH] = "WINCH",
-};
+/* Arguments of `ioprio_set()` for the idle I/O class (linux/ioprio.h) */
+#ifndef IOPRIO_WHO_PROCESS
+#define IOPRIO_WHO_PROCESS 1
+#endif
+#ifndef IOPRIO_CLASS_IDLE
+#define IOPRIO_CLASS_IDLE 3
+#endif
+#ifndef IOPRIO_CLASS_SHIFT
+#define IOPRIO_CLASS_SHIFT 13
+#endif
 
-/*!
- * Helper to get the string abbreviation of signal constants
- *
- * @param[in] sig Signal number to get the string representation of
- *
- * @return String representing the signal constant (abbreviated),
- *         or NULL if no corresponding signal string was found
- */
-static const char *sig_abbrev(int sig)
-{
-    if (sig < 0 || !((size_t)sig < sizeof(abbrevs))) {
-        return NULL;
-    }
-    return abbrevs[sig];
-}
+/* Option values for long options without a short equivalent */
+enum long_only_option {
+    OPT_SAVE = UCHAR_MAX + 1,
+    OPT_DIFF,
+    OPT_LEAK_RATE,
+    OPT_CMD_LEN,
+    OPT_STATS,
+    OPT_PROC_ROOT,
+    OPT_POLICY,
+    OPT_JOURNAL,
+    OPT_STREAM,
+    OPT_MAX_MEMORY,
+    OPT_BUDGET,
+    OPT_COUNT,
+    OPT_THRESHOLD,
+    OPT_BPF,
+};
 
 /*!
- * Attempts to find the corresponding signal number to the
- * given signal constant's name
+ * Converts the user's numeric input to a non-negative number
  *
- * @param[in] sig_str Signal name to convert
+ * @param[in] num_str Characters to convert
  *
- * @return -1 on error, the corresponding signal number otherwise
+ * @return -1 on error, the corresponding number otherwise
  */
-static int sig_str_to_num(const char *sig_str)
+static double user_number(const char *num_str)
 {
-    assert(sig_str);
+    char *end = NULL;
 
-    const char *const prefix = "SIG";
-    const size_t prefix_len  = strlen(prefix);
-    if (!strncasecmp(sig_str, prefix, prefix_len)) {
-        sig_str += prefix_len;
+    if (!num_str || !isdigit(*num_str)) {
+        return -1;
     }
-
-    for (size_t sig = 0; sig < sizeof(abbrevs) / sizeof(abbrevs[0]); ++sig) {
-        if (!abbrevs[sig]) {
-            continue;
-        }
-        if (!strcasecmp(sig_str, abbrevs[sig])) {
-            return sig;
-        }
+    errno            = 0;
+    const double num = strtod(num_str, &end);
+    if (errno || *end) {
+        return -1;
     }
-    return -1;
+    return num;
 }
 
 /*!
- * Tries to associate the user's signal input with a known
- * signal number
+ * Converts the user's numeric input to a positive count
  *
- * @param[in] sig_str Signal characters to convert
+ * @param[in] num_str Characters to convert
  *
- * @return -1 on error, the corresponding signal number otherwise
+ * @return -1 on error, the corresponding count otherwise
  */
-static int user_signal(const char *sig_str)
+static long user_count(const char *num_str)
 {
-    if (!sig_str) {
+    char *end = NULL;
+
+    if (!num_str || !isdigit(*num_str)) {
         return -1;
     }
-    if (!isdigit(*sig_str)) {
-        return sig_str_to_num(sig_str);
-    }
-
-    int sig = -1;
-    if (sscanf(sig_str, "%d", &sig) != 1 || sig < 0 || NSIG <= sig) {
+    errno           = 0;
+    const long num = strtol(num_str, &end, 10);
+    if (errno || *end || num <= 0) {
         return -1;
     }
-    return abbrevs[sig] ? sig : -1;
+    return num;
 }
 
 /*!
@@ -138,116 +138,6 @@ static void check_interactive(struct zps_settings *settings)
         isatty(STDIN_FILENO) && isatty(STDOUT_FILENO) && isatty(STDERR_FILENO);
 }
 
-/*!
- * Write colored and formatted text to the specified stream.
- *
- * Resets the display attributes before returning
- *
- * @param[in]  color         ANSI SGR control sequence parameter n (color code)
- * @param[in]  color_allowed Boolean specifying whether we can print color
- * @param[out] stream        Pointer to the file to write to
- * @param[in]  format        Format string specifying the text to print
- * @param[in]  ...           Variable format string arguments
- *
- * @return void
- */
-static void cfprintf(enum ansi_fg_color_code color, bool color_allowed,
-                     FILE *stream, const char *format, ...)
-{
-    va_list vargs;
-
-    assert(stream);
-    assert(format);
-
-    if (color_allowed) {
-        fprintf(stream, "\x1b[%dm", color);
-    }
-    va_start(vargs, format);
-    vfprintf(stream, format, vargs);
-    va_end(vargs);
-    if (color_allowed) {
-        fprintf(stream, "\x1b[%dm", ANSI_FG_NORMAL);
-    }
-}
-
-/*!
- * Write bold, colored and formatted text to the specified stream.
- *
- * Resets the display attributes before returning
- *
- * @param[in]  color         ANSI SGR control sequence parameter n (color code)
- * @param[in]  color_allowed Boolean specifying whether we can print color
- * @param[out] stream        Pointer to the file to write to
- * @param[in]  format        Format string specifying the text to print
- * @param[in]  ...           Variable format string arguments
- *
- * @return void
- */
-static void cbfprintf(enum ansi_fg_color_code color, bool color_allowed,
-                      FILE *stream, const char *format, ...)
-{
-    va_list vargs;
-
-    assert(stream);
-    assert(format);
-
-    if (color_allowed) {
-        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_BOLD);
-        if (color) {
-            fprintf(stream, "\x1b[%dm", color);
-        }
-    }
-    va_start(vargs, format);
-    vfprintf(stream, format, vargs);
-    va_end(vargs);
-    if (color_allowed) {
-        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_NORMAL);
-    }
-}
-
-/*!
- * Write bold, colored and formatted text to the specified stream.
- *
- * Encloses the bold and colored text.
- *
- * @param[in]  color         ANSI SGR control sequence parameter n (color code)
- * @param[in]  color_allowed Boolean specifying whether we can print color
- * @param[in]  before        String to put before the colored content
- * @param[in]  after         String to put after the colored content
- * @param[out] stream        Pointer to the file to write to
- * @param[in]  format        Format string specifying the text to print
- * @param[in]  ...           Variable format string arguments
- *
- * @return void
- */
-static void cbfprintf_enclosed(enum ansi_fg_color_code color,
-                               bool color_allowed, const char *before,
-                               const char *after, FILE *stream,
-                               const char *format, ...)
-{
-    va_list vargs;
-
-    assert(before);
-    assert(after);
-    assert(stream);
-    assert(format);
-
-    fprintf(stream, "%s", before);
-    if (color_allowed) {
-        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_BOLD);
-        if (color) {
-            fprintf(stream, "\x1b[%dm", color);
-        }
-    }
-    va_start(vargs, format);
-    vfprintf(stream, format, vargs);
-    va_end(vargs);
-    if (color_allowed) {
-        fprintf(stream, "\x1b[%dm", ANSI_DISPLAY_MODE_NORMAL);
-    }
-    fprintf(stream, "%s", after);
-}
-
 /*!
  * Print version and exit
  *
@@ -271,6 +161,23 @@ version_exit(int status, struct zps_settings *settings)
     exit(status);
 }
 
+/*!
+ * Lower the CPU and I/O scheduling priorities of the process to idle, so
+ * that the scans only run when nothing else wants to.
+ *
+ * Failures are ignored since the scans are paced anyway.
+ *
+ * @return void
+ */
+static void lower_priority(void)
+{
+    const struct sched_param param = {0};
+
+    sched_setscheduler(0, SCHED_IDLE, &param);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+            IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+
 /*!
  * Print help and exit
  *
@@ -287,9 +194,26 @@ static void __attribute__((noreturn)) help_exit(int status)
             "  -a, --all            list all user-space processes\n"
             "  -r, --reap           reap zombie processes\n"
             "  -s, --signal   <sig> signal to be used on zombie parents\n"
+            "      --policy  <file> per-parent signal rules\n"
+            "      --journal <file> append the sent signals to <file>\n"
             "  -p, --prompt         show prompt for selecting processes\n"
             "  -q, --quiet          reap in quiet mode\n"
-            "  -n, --no-color       disable color output\n\n");
+            "      --stream         reap while scanning (no prompt)\n"
+            "  -n, --no-color       disable color output\n"
+            "  -l, --live           show a live full-screen process list\n"
+            "  -w, --watch    <sec> repeat the scan every <sec> seconds\n"
+            "      --leak-rate <n>  only reap parents gaining <n> zombies/min\n"
+            "  -t, --top      <n>   show the <n> parents with most zombies\n"
+            "      --cmd-len  <n>   truncate command lines to <n> chars (31)\n"
+            "      --max-memory <n> keep the zombies within <n> MiB\n"
+            "      --budget   <pct> pace the scans to <pct>%% of a CPU\n"
+            "      --count          only print the zombie/parent counts\n"
+            "      --threshold <n>  fail the count above <n> zombies\n"
+            "      --stats          report the time spent in each phase\n"
+            "      --proc-root <dir> read processes from <dir> (/proc)\n"
+            "      --bpf            find the zombies with a BPF iterator\n"
+            "      --save   <file>  save the scanned process table\n"
+            "      --diff <a> <b>   compare two saved process tables\n\n");
     exit(status);
 }
 
@@ -330,11 +254,135 @@ static void settings_check(const struct zps_settings *settings)
                  "Unknown signal\n");
         failed = true;
     }
-    if (settings->sig && !settings->signal) {
+    if (settings->sig && !settings->signal && !settings->live) {
         cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
                  "The -s option has to be used with either -r or -p\n");
         failed = true;
     }
+    if (settings->policy_path && !settings->signal) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "The --policy option has to be used with either -r or -p\n");
+        failed = true;
+    }
+    if (settings->journal_path && !settings->signal) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "The --journal option has to be used with either -r or -p\n");
+        failed = true;
+    }
+    if (settings->interval < 0) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid interval\n");
+        failed = true;
+    }
+    if (settings->leak_rate < 0) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid leak rate\n");
+        failed = true;
+    } else if (settings->leak_rate != INFINITY && !settings->interval) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "The --leak-rate option has to be used with -w\n");
+        failed = true;
+    }
+    if (settings->cmd_len < 0 || settings->cmd_len > ZPS_CMD_MAX_LEN) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid command line length\n");
+        failed = true;
+    }
+    if (settings->max_memory < 0 ||
+        settings->max_memory > (long)(SIZE_MAX >> 21)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid memory budget\n");
+        failed = true;
+    } else if (settings->max_memory) {
+        /* Half of the budget has to hold the strings of a zombie */
+        if ((size_t)settings->max_memory << 19 <
+            (size_t)settings->cmd_len + ZPS_TASK_COMM_LEN + 1) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "The --max-memory budget is too small for --cmd-len\n");
+            failed = true;
+        }
+        if (settings->prompt || settings->save_path) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "Incompatible options: --max-memory, -p/--save\n");
+            failed = true;
+        }
+    }
+    if (settings->bpf && strcmp(settings->proc_root, ZPS_PROC_FILESYSTEM)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Incompatible options: --bpf, --proc-root\n");
+        failed = true;
+    }
+    if (settings->budget != INFINITY &&
+        (settings->budget <= 0 || settings->budget > 100)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid CPU budget\n");
+        failed = true;
+    }
+    if (settings->threshold < 0) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid zombie threshold\n");
+        failed = true;
+    } else if (settings->threshold != INFINITY && !settings->count) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "The --threshold option requires --count\n");
+        failed = true;
+    }
+    if (settings->count &&
+        (settings->show_all || settings->signal || settings->live ||
+         settings->interval || settings->top ||
+         settings->leak_rate != INFINITY || settings->max_memory ||
+         settings->save_path || settings->policy_path ||
+         settings->journal_path)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Incompatible options: --count, -a/-r/-p/-q/-l/-w/-t/"
+                 "--leak-rate/--max-memory/--save/--policy/--journal/"
+                 "--stream\n");
+        failed = true;
+    }
+    if (settings->top < 0 || settings->top > PID_MAX_LIMIT) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Invalid number of parents\n");
+        failed = true;
+    } else if (settings->top) {
+        if (settings->show_all) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "Incompatible options: -t, -a\n");
+            failed = true;
+        }
+        if (settings->prompt) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "Incompatible options: -t, -p\n");
+            failed = true;
+        }
+        if (settings->leak_rate != INFINITY) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "Incompatible options: -t, --leak-rate\n");
+            failed = true;
+        }
+    }
+    if (settings->live) {
+        if (!settings->interactive) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "The -l option requires a terminal\n");
+            failed = true;
+        }
+        if (settings->quiet || settings->prompt || settings->top ||
+            settings->leak_rate != INFINITY || settings->policy_path ||
+            settings->journal_path || settings->stream ||
+            settings->budget != INFINITY || settings->bpf) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "Incompatible options: -l, -q/-p/-t/--leak-rate/"
+                     "--policy/--journal/--stream/--budget/--bpf\n");
+            failed = true;
+        }
+    }
+    if (settings->stream &&
+        (settings->prompt || settings->top ||
+         settings->leak_rate != INFINITY)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Incompatible options: --stream, -p/-t/--leak-rate\n");
+        failed = true;
+    }
     if (settings->quiet) {
         if (settings->show_all) {
             cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
@@ -372,15 +420,32 @@ static void parse_args(int argc, char *argv[], struct zps_settings *settings)
         {  "signal", required_argument, NULL, 's'},
         {  "prompt",       no_argument, NULL, 'p'},
         {   "quiet",       no_argument, NULL, 'q'},
+        {  "stream",       no_argument, NULL, OPT_STREAM},
         {"no-color",       no_argument, NULL, 'n'},
+        {    "live",       no_argument, NULL, 'l'},
+        {   "watch", required_argument, NULL, 'w'},
+        {     "top", required_argument, NULL, 't'},
+        {"leak-rate", required_argument, NULL, OPT_LEAK_RATE},
+        { "cmd-len", required_argument, NULL, OPT_CMD_LEN},
+        {"max-memory", required_argument, NULL, OPT_MAX_MEMORY},
+        {  "budget", required_argument, NULL, OPT_BUDGET},
+        {   "count",       no_argument, NULL, OPT_COUNT},
+        {"threshold", required_argument, NULL, OPT_THRESHOLD},
+        {     "bpf",       no_argument, NULL, OPT_BPF},
+        {   "stats",       no_argument, NULL, OPT_STATS},
+        {"proc-root", required_argument, NULL, OPT_PROC_ROOT},
+        {  "policy", required_argument, NULL, OPT_POLICY},
+        { "journal", required_argument, NULL, OPT_JOURNAL},
+        {    "save", required_argument, NULL, OPT_SAVE},
+        {    "diff", required_argument, NULL, OPT_DIFF},
         {      NULL,                 0, NULL,   0},
     };
 
     assert(argv);
     assert(settings);
 
-    for (int opt;
-         (opt = getopt_long(argc, argv, "vhars:pqn", longopts, NULL)) != -1;) {
+    for (int opt; (opt = getopt_long(argc, argv, "vhars:pqnlw:t:", longopts,
+                                     NULL)) != -1;) {
         switch (opt) {
         case 'v': /* Show version information. */
             version_exit(EXIT_SUCCESS, settings);
@@ -393,7 +458,7 @@ static void parse_args(int argc, char *argv[], struct zps_settings *settings)
             settings->signal = true;
             break;
         case 's': /* User-specified zombie parent signal. */
-            settings->sig = user_signal(optarg);
+            settings->sig = zps_user_signal(optarg);
             break;
         case 'p': /* Show a prompt for interactive reaping. */
             settings->prompt = true;
@@ -403,9 +468,65 @@ static void parse_args(int argc, char *argv[], struct zps_settings *settings)
             settings->quiet  = true;
             settings->signal = true;
             break;
+        case OPT_STREAM: /* Reap during the scan. */
+            settings->stream = true;
+            settings->signal = true;
+            break;
         case 'n': /* Disable color output. */
             settings->color_allowed = false;
             break;
+        case 'l': /* Interactive full-screen mode. */
+            settings->live = true;
+            break;
+        case 'w': /* Repeat the scan periodically. */
+            settings->interval = user_number(optarg);
+            break;
+        case 't': /* Show the parents with the most zombies. */
+            settings->top = user_count(optarg);
+            break;
+        case OPT_LEAK_RATE: /* Zombie growth rate of leaking parents. */
+            settings->leak_rate = user_number(optarg);
+            break;
+        case OPT_CMD_LEN: /* Maximum length of the command lines. */
+            settings->cmd_len = user_count(optarg);
+            break;
+        case OPT_MAX_MEMORY: /* Memory budget of the found zombies. */
+            settings->max_memory = user_count(optarg);
+            break;
+        case OPT_BUDGET: /* Share of a CPU the scans may use. */
+            settings->budget = user_number(optarg);
+            break;
+        case OPT_COUNT: /* Only count the zombies and their parents. */
+            settings->count = true;
+            break;
+        case OPT_THRESHOLD: /* Number of zombies failing the count. */
+            settings->threshold = user_number(optarg);
+            break;
+        case OPT_STATS: /* Report the time spent in each phase. */
+            settings->show_stats = true;
+            break;
+        case OPT_PROC_ROOT: /* Alternative `/proc` filesystem. */
+            settings->proc_root = optarg;
+            break;
+        case OPT_BPF: /* Find the zombies in the kernel. */
+            settings->bpf = true;
+            break;
+        case OPT_POLICY: /* Per-parent signal rules. */
+            settings->policy_path = optarg;
+            break;
+        case OPT_JOURNAL: /* Record the sent signals. */
+            settings->journal_path = optarg;
+            break;
+        case OPT_SAVE: /* Save the process table to a snapshot file. */
+            settings->save_path = optarg;
+            break;
+        case OPT_DIFF: /* Compare two snapshot files. */
+            if (optind >= argc || argv[optind][0] == '-') {
+                help_exit(EXIT_FAILURE);
+            }
+            settings->diff_paths[0] = optarg;
+            settings->diff_paths[1] = argv[optind++];
+            break;
         default:
             help_exit(EXIT_FAILURE);
         }
@@ -415,274 +536,623 @@ static void parse_args(int argc, char *argv[], struct zps_settings *settings)
 }
 
 /*!
- * Read the given file and return its content.
+ * Constructs an empty leak table.
  *
- * @param[in,out] buf    Buffer to read bytes from the file into
- * @param[in]     bufsiz Size of allocated `buf`
- * @param[in]     format Format string specifying the file path
- * @param[in]     ...    Variable format string arguments
+ * The `leak_table_free()` function should be called on this return value
+ * in order to free the resources.
  *
- * @return number of bytes successfully read (max: `bufsiz - 1`),
-           `-1` on error
+ * @return Pointer to the allocated structure, `NULL` on error
  */
-static ssize_t read_file(char *buf, size_t bufsiz, const char *format, ...)
+static struct leak_table *leak_table(void)
 {
-    va_list vargs;
-    char path[PATH_MAX] = {0};
-
-    assert(buf);
-    assert(bufsiz > 0);
-    assert(format);
-
-    va_start(vargs, format);
-    int num_required = vsnprintf(path, sizeof(path), format, vargs);
-    va_end(vargs);
-    /* Check for errors or truncation */
-    if (num_required < 0 || (size_t)num_required >= sizeof(path)) {
-        return -1;
+    struct leak_table *table = calloc(1, sizeof(*table));
+    if (!table) {
+        return NULL;
     }
-
-    const int fd = open(path, O_RDONLY);
-    if (fd == -1) {
-        return -1;
+    table->index = pid_map(LEAK_TABLE_SIZE);
+    if (!table->index) {
+        free(table);
+        return NULL;
     }
-    memset(buf, '\0', bufsiz);
-    ssize_t read_rc = read(fd, buf, bufsiz - 1);
-    close(fd);
 
-    return read_rc;
+    return table;
 }
 
 /*!
- * Parse the content of `"/proc/<pid>/stat"` into `proc_stats`.
+ * Frees and invalidates the leak table pointed to by the `table`.
  *
- * @param[in,out] stat_buf   Null-terminated buffer containing the contents of
-                             `"/proc/<pid>/stat"` from offset `0`; will be
-                             modified during execution
- * @param[out]    proc_stats Pointer to write the process information to
+ * @param[out] table Leak table to deallocate
  *
- * @return `-1` on error, otherwise `0` is returned
+ * @return void
  */
-static int parse_stat_content(char *stat_buf, struct proc_stats *proc_stats)
+static void leak_table_free(struct leak_table *table)
 {
-    assert(stat_buf);
-    assert(proc_stats);
-
-    /* Start with the PID field */
-    if (sscanf(stat_buf, "%d", &proc_stats->pid) != 1) {
-        return -1;
-    }
-
-    /* Pointer bounds for `comm` in the buffer */
-    const char *begin = strchr(stat_buf, '(');
-    if (!begin) {
-        return -1;
-    }
-    char *const end = strrchr(begin, ')');
-    if (!end || end[1] == '\0') {
-        return -1;
-    }
-    ++begin;
-    const char *const last_fields = end + 2;
-    /*
-        begin:
-            %d (...) %c %d
-                ^
-        end:
-            %d (...) %c %d
-                   ^
-        last_fields:
-            %d (...) %c %d
-                     ^
-    */
-    /* Extract the last fields first */
-    if (sscanf(last_fields, "%c %d", &proc_stats->state, &proc_stats->ppid) !=
-        2) {
-        return -1;
+    if (!table) {
+        return;
     }
+    pid_map_free(table->index);
+    free(table);
+}
 
-    /* Limit `comm_strlen` */
-    *end                     = '\0';
-    const size_t comm_strlen = strnlen(begin, sizeof(proc_stats->name) - 1);
-    /* Extract the process name (limited by `comm_strlen`) */
-    memcpy(proc_stats->name, begin, comm_strlen);
-    /* Make sure string ends here */
-    proc_stats->name[comm_strlen] = '\0';
+/*!
+ * Removes the entry at index `i` from `table` by moving the last one into it.
+ *
+ * @param[out] table Leak table to use
+ * @param[in]  i     Index of the entry to remove
+ *
+ * @return void
+ */
+static void leak_table_remove(struct leak_table *table, size_t i)
+{
+    assert(table);
+    assert(i < table->sz);
 
-    return 0;
+    pid_map_remove(table->index, table->entries[i].ppid);
+    if (i != --table->sz) {
+        table->entries[i] = table->entries[table->sz];
+        pid_map_put(table->index, table->entries[i].ppid, i);
+    }
 }
 
 /*!
- * Parse and return the stats for a given PID.
+ * Count a zombie of the given parent in the current iteration.
  *
- * @param[in]  pid        String containing the PID
- * @param[out] proc_stats Pointer to the struct to write to
+ * The parent's start time is read once per iteration and a changed start
+ * time resets the entry since the PID got reused by another process.
  *
- * @return `-1` on error, `0` otherwise
+ * @param[out] table Leak table to update
+ * @param[in]  ppid  PID of the zombie's parent
+ * @param[in]  dirfd Open `/proc` directory
+ *
+ * @return void
  */
-static int get_proc_stats(const char *pid, struct proc_stats *proc_stats)
+static void leak_table_count(struct leak_table *table, pid_t ppid, int dirfd)
 {
-    char stat_buf[MAX_BUF_SIZE] = {0};
+    assert(table);
 
-    assert(pid);
-    assert(proc_stats);
-
-    /* Read the `"/proc/<pid>/stat"` file. */
-    if (read_file(stat_buf, sizeof(stat_buf), "%s/%s/%s", PROC_FILESYSTEM, pid,
-                  STAT_FILE) == -1) {
-        return -1;
-    }
-    if (parse_stat_content(stat_buf, proc_stats)) {
-        return -1;
+    if (ppid <= 0) {
+        return;
     }
-    /* We do not want kernel processes/threads */
-    if (proc_stats->ppid == KTHREADD_PID || proc_stats->pid == KTHREADD_PID) {
-        return -1;
+    const size_t *const index = pid_map_find(table->index, ppid);
+    struct leak_entry *entry  = index ? &table->entries[*index] : NULL;
+    if (entry && entry->generation == table->generation) {
+        ++entry->zombies;
+        return;
     }
 
-    /* Read the `"/proc/<pid>/cmdline"` file */
-    const ssize_t cmd_len = read_file(proc_stats->cmd, sizeof(proc_stats->cmd),
-                                      "%s/%s/%s", PROC_FILESYSTEM, pid,
-                                      CMD_FILE);
-    if (cmd_len == -1) {
-        return -1;
+    unsigned long long starttime = 0;
+    if (zps_get_proc_starttime(dirfd, ppid, &starttime)) {
+        return;
     }
-
-    /* Replace any null bytes with spaces to also print further arguments */
-    for (size_t i = 0; i < (size_t)cmd_len; ++i) {
-        if (!proc_stats->cmd[i]) {
-            proc_stats->cmd[i] = ' ';
+    if (entry && entry->starttime != starttime) {
+        leak_table_remove(table, *index);
+        entry = NULL;
+    }
+    if (!entry) {
+        /* Parents beyond the capacity are not tracked */
+        if (table->sz == LEAK_TABLE_SIZE) {
+            return;
         }
+        entry  = &table->entries[table->sz];
+        *entry = (struct leak_entry){
+            .ppid       = ppid,
+            .starttime  = starttime,
+            .generation = table->generation,
+        };
+        pid_map_put(table->index, ppid, table->sz++);
+    } else {
+        entry->zombies    = 0;
+        entry->generation = table->generation;
     }
-
-    return 0;
+    ++entry->zombies;
 }
 
 /*!
- * Send signal to the given PPID of the `proc_stats` entry.
+ * Finish an iteration and update the growth rate of the tracked parents.
  *
- * @param[in]  proc_stats Pointer to the entry to send the signal for
- * @param[in]  settings   Pointer to user-specified settings (signal?)
- * @param[out] stats      The `signaled_procs` field will be updated
- * @param[in]  verbose    Boolean specifying the behavior (print result)
+ * New parents only get their baseline in the first iteration they are seen
+ * and parents without zombies are dropped from the table.
  *
- * @return `-1` on error, otherwise `0` is returned
+ * @param[out] table   Leak table to update
+ * @param[in]  minutes Time passed since the previous iteration
+ *
+ * @return void
  */
-static int handle_zombie(const struct proc_stats *proc_stats,
-                         const struct zps_settings *settings,
-                         struct zps_stats *stats, bool verbose)
+static void leak_table_update(struct leak_table *table, double minutes)
 {
-    assert(proc_stats);
-    assert(settings);
-    assert(stats);
+    assert(table);
 
-    const pid_t ppid = proc_stats->ppid;
-    if (ppid <= 0 || ppid == INIT_PID || ppid == KTHREADD_PID) {
-        return -1;
-    }
-    const int sig     = settings->sig ? settings->sig : SIGTERM;
-    const int kill_rc = kill(ppid, sig);
-    if (!kill_rc) {
-        ++stats->signaled_procs;
-        const char *const sigabbrev = sig_abbrev(sig);
-        if (verbose) {
-            cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed, "\n[", "]",
-                               stdout, "SIG%s",
-                               sigabbrev ? sigabbrev : "Unknown signal");
+    for (size_t i = table->sz; i-- > 0;) {
+        struct leak_entry *const entry = &table->entries[i];
+        if (entry->generation != table->generation) {
+            leak_table_remove(table, i);
+            continue;
         }
-    } else if (verbose) {
-        cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed, "\n[", "]",
-                           stdout, "Failed to signal");
+        if (entry->prev_zombies && minutes > 0) {
+            const double growth =
+                ((double)entry->zombies - (double)entry->prev_zombies) /
+                minutes;
+            entry->rate = LEAK_EWMA_ALPHA * growth +
+                          (1 - LEAK_EWMA_ALPHA) * entry->rate;
+        }
+        /* Becomes the previous count if no zombies are seen next time */
+        entry->prev_zombies = entry->zombies;
     }
-    return kill_rc;
+    ++table->generation;
 }
 
 /*!
- * Iterate over found zombies and list information while doing so.
- *
- * If the user is not to be prompted, this function immediately sends a signal.
+ * Check whether the given parent is gaining zombies faster than allowed.
  *
- * @param[in]  defunct_procs Pointer to the zombie process vector
- * @param[in]  settings      Pointer to user-specified settings (signal?)
- * @param[out] stats         The `signaled_procs` field will be updated
+ * @param[in] table    Leak table to use
+ * @param[in] ppid     PID of the parent
+ * @param[in] settings Pointer to user-specified settings (leak rate)
  *
- * @return void
+ * @return `true` if the parent is leaking zombies, `false` otherwise
  */
-static void handle_found_zombies(const struct proc_vec *defunct_procs,
-                                 const struct zps_settings *settings,
-                                 struct zps_stats *stats)
+static bool leak_table_leaking(const struct leak_table *table, pid_t ppid,
+                               const struct zps_settings *settings)
 {
-    assert(defunct_procs);
+    assert(table);
     assert(settings);
-    assert(stats);
 
-    for (size_t i = 0, sz = proc_vec_size(defunct_procs); i < sz; ++i) {
-        const struct proc_stats *const entry = proc_vec_at(defunct_procs, i);
-        if (!settings->prompt) {
-            handle_zombie(entry, settings, stats, true);
-        } else {
-            cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed, "\n[", "]",
-                               stdout, "%zu", i + 1);
+    const size_t *const index =
+        ppid > 0 ? pid_map_find(table->index, ppid) : NULL;
+    return index && table->entries[*index].rate > settings->leak_rate;
+}
+
+/*!
+ * Constructs an empty leaderboard of at most `max_sz` zombie parents.
+ *
+ * The `top_heap_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @param[in] max_sz Maximum number of parents to keep
+ *
+ * @return Pointer to the allocated structure, `NULL` on error
+ */
+static struct top_heap *top_heap(size_t max_sz)
+{
+    assert(max_sz > 0);
+
+    struct top_heap *heap = calloc(1, sizeof(*heap));
+    if (!heap) {
+        return NULL;
+    }
+    heap->max_sz  = max_sz;
+    heap->entries = malloc(max_sz * sizeof(*heap->entries));
+    heap->index   = pid_map(max_sz);
+    if (!heap->entries || !heap->index) {
+        free(heap->entries);
+        pid_map_free(heap->index);
+        free(heap);
+        return NULL;
+    }
+
+    return heap;
+}
+
+/*!
+ * Frees and invalidates the leaderboard pointed to by the `heap`.
+ *
+ * @param[out] heap Leaderboard to deallocate
+ *
+ * @return void
+ */
+static void top_heap_free(struct top_heap *heap)
+{
+    if (!heap) {
+        return;
+    }
+    free(heap->entries);
+    pid_map_free(heap->index);
+    free(heap);
+}
+
+/*!
+ * Swaps two entries of `heap` and keeps the index up to date.
+ *
+ * @param[out] heap Leaderboard to use
+ * @param[in]  i    Index of the first entry
+ * @param[in]  j    Index of the second entry
+ *
+ * @return void
+ */
+static void top_heap_swap(struct top_heap *heap, size_t i, size_t j)
+{
+    const struct top_entry tmp = heap->entries[i];
+    heap->entries[i]           = heap->entries[j];
+    heap->entries[j]           = tmp;
+    pid_map_put(heap->index, heap->entries[i].ppid, i);
+    pid_map_put(heap->index, heap->entries[j].ppid, j);
+}
+
+/*!
+ * Moves the entry at index `i` down until the min-heap order is restored.
+ *
+ * @param[out] heap Leaderboard to use
+ * @param[in]  i    Index of the entry whose count was increased
+ *
+ * @return void
+ */
+static void top_heap_sift_down(struct top_heap *heap, size_t i)
+{
+    for (;;) {
+        size_t min          = i;
+        const size_t left   = 2 * i + 1;
+        const size_t right  = left + 1;
+        if (left < heap->sz &&
+            heap->entries[left].zombies < heap->entries[min].zombies) {
+            min = left;
+        }
+        if (right < heap->sz &&
+            heap->entries[right].zombies < heap->entries[min].zombies) {
+            min = right;
+        }
+        if (min == i) {
+            return;
+        }
+        top_heap_swap(heap, i, min);
+        i = min;
+    }
+}
+
+/*!
+ * Count a zombie for its parent in the leaderboard.
+ *
+ * @param[out] heap  Leaderboard to update
+ * @param[in]  entry Pointer to the zombie's process stats
+ *
+ * @return void
+ */
+static void top_heap_add(struct top_heap *heap, const struct zps_proc *entry)
+{
+    assert(heap);
+    assert(entry);
+
+    if (entry->ppid <= 0) {
+        return;
+    }
+    ++heap->total;
+
+    const size_t *const index = pid_map_find(heap->index, entry->ppid);
+    if (index) {
+        struct top_entry *const top = &heap->entries[*index];
+        ++top->zombies;
+        if (entry->starttime < top->oldest_starttime) {
+            top->oldest_pid       = entry->pid;
+            top->oldest_starttime = entry->starttime;
         }
+        top_heap_sift_down(heap, *index);
+        return;
+    }
 
-        fprintf(stdout,
-                "\n Name:    %s\n PID:     %d\n PPID:    %d\n State:   %c\n",
-                entry->name, entry->pid, entry->ppid, entry->state);
+    const struct top_entry top = {
+        .ppid             = entry->ppid,
+        .oldest_pid       = entry->pid,
+        .oldest_starttime = entry->starttime,
+        .zombies          = 1,
+    };
+    if (heap->sz < heap->max_sz) {
+        /* A count of `1` is always the minimum, so it is a valid leaf */
+        size_t i         = heap->sz++;
+        heap->entries[i] = top;
+        pid_map_put(heap->index, top.ppid, i);
+        for (; i && heap->entries[(i - 1) / 2].zombies > 1; i = (i - 1) / 2) {
+            top_heap_swap(heap, i, (i - 1) / 2);
+        }
+        return;
     }
+
+    /* Replace the parent with the fewest zombies */
+    struct top_entry *const min = &heap->entries[0];
+    pid_map_remove(heap->index, min->ppid);
+    const size_t zombies = min->zombies;
+    *min                 = top;
+    min->zombies         = zombies + 1;
+    min->error           = zombies;
+    pid_map_put(heap->index, min->ppid, 0);
+    top_heap_sift_down(heap, 0);
 }
 
 /*!
- * Iterate through `"/proc"` and save found zombie entries.
+ * Send signal to the given PPID of a zombie.
+ *
+ * @param[in]  pid      PID of the zombie (for the journal)
+ * @param[in]  ppid     PID of the zombie's parent to send the signal to
+ * @param[in]  settings Pointer to user-specified settings (signal?)
+ * @param[out] stats    The `signaled_procs` field will be updated
+ * @param[in]  verbose  Boolean specifying the behavior (print result)
+ *
+ * @return `-1` on error (with `errno` set), otherwise `0` is returned
+ */
+static int handle_zombie(pid_t pid, pid_t ppid,
+                         const struct zps_settings *settings,
+                         struct zps_stats *stats, bool verbose)
+{
+    assert(settings);
+    assert(stats);
+
+    if (ppid <= 0 || ppid == ZPS_INIT_PID || ppid == ZPS_KTHREADD_PID) {
+        /* Never signal `init` or `kthreadd` */
+        errno = EPERM;
+        return -1;
+    }
+    struct zps_perf *const perf = settings->show_stats ? &stats->perf : NULL;
+    int sig                     = settings->sig ? settings->sig : SIGTERM;
+    /* The policy may pick another signal or none at all */
+    if (settings->policy &&
+        !(sig = policy_signal(settings->policy, ppid, sig))) {
+        if (verbose) {
+            cbfprintf_enclosed(ANSI_FG_YELLOW, settings->color_allowed, "\n[",
+                               "]", stdout, "Ignored");
+        }
+        return -1;
+    }
+    /* The parent has to be looked up before it gets terminated */
+    const char *const name =
+        settings->journal ? journal_name(settings->journal, ppid) : NULL;
+    const uint64_t begin = zps_perf_begin(perf);
+    const int kill_rc    = zps_signal_parent(ppid, sig);
+    const int err        = errno;
+    zps_perf_end(perf, ZPS_PHASE_SIGNAL, begin);
+    if (perf) {
+        ++perf->syscalls;
+    }
+    if (settings->journal) {
+        /* Written out when the scan is committed */
+        journal_record(settings->journal, pid, ppid, name, sig,
+                       kill_rc ? err : 0);
+    }
+    if (!kill_rc) {
+        ++stats->signaled_procs;
+        const char *const sigabbrev = zps_sig_abbrev(sig);
+        if (verbose) {
+            cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed, "\n[", "]",
+                               stdout, "SIG%s",
+                               sigabbrev ? sigabbrev : "Unknown signal");
+        }
+    } else if (verbose) {
+        cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed, "\n[", "]",
+                           stdout, "Failed to signal");
+    }
+    errno = err;
+    return kill_rc;
+}
+
+/*!
+ * Iterate over found zombies and list information while doing so.
+ *
+ * If the user is not to be prompted, this function immediately sends a signal.
  *
- * @param[out] defunct_procs Pointer to the zombie process vector to fill
- * @param[in]  settings      Pointer to user-specified settings (list?)
- * @param[out] stats         The `defunct_count` field will be updated
+ * @param[in]  defunct_procs Pointer to the zombie process vector
+ * @param[in]  leaks         Pointer to the leak table limiting the parents
+ *                           to signal, may be `NULL`
+ * @param[in]  settings      Pointer to user-specified settings (signal?)
+ * @param[out] stats         The `signaled_procs` field will be updated
  *
  * @return void
  */
-static void proc_iter(struct proc_vec *defunct_procs,
-                      const struct zps_settings *settings,
-                      struct zps_stats *stats)
+static void handle_found_zombies(const struct proc_vec *defunct_procs,
+                                 const struct leak_table *leaks,
+                                 const struct zps_settings *settings,
+                                 struct zps_stats *stats)
 {
     assert(defunct_procs);
     assert(settings);
     assert(stats);
 
-    DIR *dir = opendir(PROC_FILESYSTEM);
-    if (dir == NULL) {
-        return;
+    struct zps_perf *const perf = settings->show_stats ? &stats->perf : NULL;
+    for (size_t i = 0, sz = proc_vec_size(defunct_procs); i < sz; ++i) {
+        const struct proc_entry *const entry = proc_vec_at(defunct_procs, i);
+        if (!settings->prompt) {
+            if (leaks && !leak_table_leaking(leaks, entry->ppid, settings)) {
+                continue;
+            }
+            handle_zombie(entry->pid, entry->ppid, settings, stats, true);
+        } else {
+            cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed, "\n[", "]",
+                               stdout, "%zu", i + 1);
+        }
+
+        const uint64_t begin = zps_perf_begin(perf);
+        fprintf(stdout,
+                "\n Name:    %s\n PID:     %d\n PPID:    %d\n State:   %c\n",
+                proc_vec_str(defunct_procs, entry->name_off), entry->pid,
+                entry->ppid, entry->state);
+        zps_perf_end(perf, ZPS_PHASE_OUTPUT, begin);
     }
+}
 
-    for (;;) {
-        struct dirent *d = readdir(dir);
-        if (d == NULL) {
-            break;
-        }
-        if (!(d->d_type == DT_DIR && isdigit(d->d_name[0]))) {
-            continue;
-        }
+/* Struct for the state of `proc_iter()` passed to its callback */
+struct proc_iter_state {
+    struct proc_spill *defunct_procs;
+    /* Parents signaled during the scan (streaming mode) */
+    struct pid_map *parents;
+    struct proc_vec *all_procs;
+    struct top_heap *top;
+    const struct zps_settings *settings;
+    struct zps_stats *stats;
+    struct zps_perf *perf;
+    /* Boolean value for a failed allocation */
+    bool failed;
+};
 
-        struct proc_stats proc_stats = {0};
-        /*  Get the process stats from the path. */
-        if (get_proc_stats(d->d_name, &proc_stats)) {
-            continue;
-        } else if (proc_stats.state == STATE_ZOMBIE) {
-            ++stats->defunct_count;
+/* Format of a listed process (see `PID_COL_WIDTH` and the others) */
+#define PROC_ROW_FORMAT "%-*d %-*d %-*c %*.*s %s\n"
+
+/*!
+ * Save and print a scanned process, specialized by the output mode.
+ *
+ * This is instantiated for every output mode by `PROC_ITER_CB()` with
+ * constant arguments, so the per-process path does not test the settings
+ * and the formatting is compiled out in quiet mode.
+ *
+ * @param[in]     proc_stats Pointer to the scanned process
+ * @param[in,out] state      Pointer to the `proc_iter_state`
+ * @param[in]     show_all   Boolean value for listing every process
+ * @param[in]     color      Boolean value for colored output
+ * @param[in]     quiet      Boolean value for not printing anything
+ *
+ * @return `0` to continue the scan, `1` to stop it on error
+ */
+static inline __attribute__((always_inline)) int
+proc_iter_visit(const struct zps_proc *proc_stats,
+                struct proc_iter_state *state, const bool show_all,
+                const bool color, const bool quiet)
+{
+    struct zps_perf *const perf = state->perf;
+
+    uint64_t begin       = zps_perf_begin(perf);
+    const bool is_zombie = proc_stats->state == ZPS_STATE_ZOMBIE;
+    if (state->all_procs) {
+        /* Keep every process for the snapshot (could fail) */
+        proc_vec_add(state->all_procs, proc_stats);
+    }
+    if (is_zombie) {
+        ++state->stats->defunct_count;
+        if (state->top) {
+            /* Only aggregate the zombie by its parent */
+            top_heap_add(state->top, proc_stats);
+        } else if (!state->parents) {
             /* Add process to the array of defunct processes (could fail) */
-            proc_vec_add(defunct_procs, proc_stats);
+            proc_spill_add(state->defunct_procs, proc_stats);
+        }
+    }
+    zps_perf_end(perf, ZPS_PHASE_FILTER, begin);
+    /* Print the process's stats (in a single call with the colors). */
+    if (!quiet && (show_all || (is_zombie && !state->top))) {
+        begin = zps_perf_begin(perf);
+        if (color) {
+            fprintf(stdout, "\x1b[%dm" PROC_ROW_FORMAT "\x1b[%dm",
+                    is_zombie ? ANSI_FG_RED : ANSI_FG_NORMAL, PID_COL_WIDTH,
+                    proc_stats->pid, PPID_COL_WIDTH, proc_stats->ppid,
+                    STATE_COL_WIDTH, proc_stats->state, NAME_COL_WIDTH,
+                    NAME_COL_WIDTH, proc_stats->name, proc_stats->cmd,
+                    ANSI_FG_NORMAL);
+        } else {
+            fprintf(stdout, PROC_ROW_FORMAT, PID_COL_WIDTH, proc_stats->pid,
+                    PPID_COL_WIDTH, proc_stats->ppid, STATE_COL_WIDTH,
+                    proc_stats->state, NAME_COL_WIDTH, NAME_COL_WIDTH,
+                    proc_stats->name, proc_stats->cmd);
+        }
+        zps_perf_end(perf, ZPS_PHASE_OUTPUT, begin);
+    }
+    /* Signal every parent once, as soon as its first zombie is found */
+    if (is_zombie && state->parents &&
+        !pid_map_find(state->parents, proc_stats->ppid)) {
+        if (!pid_map_put(state->parents, proc_stats->ppid, 0)) {
+            /* Move the parents to a map twice as large */
+            if (!pid_map_grow(&state->parents)) {
+                state->failed = true;
+                return 1;
+            }
+            pid_map_put(state->parents, proc_stats->ppid, 0);
         }
-        /* Print the process's stats. */
-        if (settings->show_all || proc_stats.state == STATE_ZOMBIE) {
-            cfprintf(
-                proc_stats.state == STATE_ZOMBIE ? ANSI_FG_RED : ANSI_FG_NORMAL,
-                settings->color_allowed, stdout, "%-*d %-*d %-*c %*.*s %s\n",
-                PID_COL_WIDTH, proc_stats.pid, PPID_COL_WIDTH, proc_stats.ppid,
-                STATE_COL_WIDTH, proc_stats.state, NAME_COL_WIDTH,
-                NAME_COL_WIDTH, proc_stats.name, proc_stats.cmd);
+        /* The zombies are not listed with the leaderboard */
+        const bool verbose = !quiet && !state->top;
+        handle_zombie(proc_stats->pid, proc_stats->ppid, state->settings,
+                      state->stats, verbose);
+        if (verbose) {
+            fputc('\n', stdout);
         }
     }
 
-    closedir(dir);
+    return 0;
+}
+
+/* Defines a `zps_scan()` callback for an output mode */
+#define PROC_ITER_CB(name, show_all, color, quiet)                           \
+    static int name(const struct zps_proc *proc_stats, void *userdata)       \
+    {                                                                        \
+        return proc_iter_visit(proc_stats, userdata, show_all, color, quiet); \
+    }
+
+PROC_ITER_CB(proc_iter_zombies, false, false, false)
+PROC_ITER_CB(proc_iter_zombies_color, false, true, false)
+PROC_ITER_CB(proc_iter_all, true, false, false)
+PROC_ITER_CB(proc_iter_all_color, true, true, false)
+PROC_ITER_CB(proc_iter_quiet, false, false, true)
+
+/*!
+ * Select the `zps_scan()` callback for the output mode of the settings.
+ *
+ * @param[in] settings Pointer to user-specified settings (list? color?)
+ *
+ * @return Callback to pass a `proc_iter_state` to
+ */
+static zps_scan_cb proc_iter_select(const struct zps_settings *settings)
+{
+    assert(settings);
+
+    /* Standard output is silenced in quiet mode */
+    if (settings->quiet) {
+        return proc_iter_quiet;
+    }
+    if (settings->show_all) {
+        return settings->color_allowed ? proc_iter_all_color : proc_iter_all;
+    }
+    return settings->color_allowed ? proc_iter_zombies_color
+                                   : proc_iter_zombies;
+}
+
+/*!
+ * Iterate through `"/proc"` and save found zombie entries.
+ *
+ * @param[in,out] ctx           Pointer to the scan context
+ * @param[out]    defunct_procs Pointer to the spill of the zombies to fill
+ * @param[in,out] parents       Pointer to the map of the signaled parents to
+ *                              signal the zombies' parents while scanning
+ *                              instead of filling `defunct_procs` (replaced
+ *                              by a larger map when full), may point to
+ *                              `NULL`
+ * @param[out]    all_procs     Pointer to a vector to fill with every scanned
+ *                              process, may be `NULL`
+ * @param[out]    top           Pointer to the leaderboard to count the
+ *                              zombies in instead of listing them, may be
+ *                              `NULL`
+ * @param[in]     visit         Callback for the output mode (see
+ *                              `proc_iter_select()`)
+ * @param[in]     settings      Pointer to user-specified settings (list?)
+ * @param[out]    stats         The `defunct_count` field will be updated
+ *
+ * @return `-1` if the processes could not be enumerated or the signaled
+ *         parents could not be stored, otherwise `0` is returned
+ */
+static int proc_iter(struct zps_ctx *ctx, struct proc_spill *defunct_procs,
+                     struct pid_map **parents, struct proc_vec *all_procs,
+                     struct top_heap *top, zps_scan_cb visit,
+                     const struct zps_settings *settings,
+                     struct zps_stats *stats)
+{
+    assert(ctx);
+    assert(visit);
+    assert(parents);
+    assert(defunct_procs || *parents);
+    assert(settings);
+    assert(stats);
+
+    struct proc_iter_state state = {
+        .defunct_procs = defunct_procs,
+        .parents       = *parents,
+        .all_procs     = all_procs,
+        .top           = top,
+        .settings      = settings,
+        .stats         = stats,
+        .perf          = settings->show_stats ? &stats->perf : NULL,
+    };
+    /* Other processes are only needed for listing or saving them */
+    const struct zps_filter filter = {
+        .zombies_only = !settings->show_all && !all_procs,
+        .skip_cmd     = settings->quiet && !all_procs,
+    };
+    const int rc = zps_scan(ctx, &filter, visit, &state);
+    *parents     = state.parents;
+    if (state.failed) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return rc;
 }
 
 /*!
@@ -728,10 +1198,11 @@ static void prompt_user(const struct proc_vec *defunct_procs,
             continue;
         }
 
-        const struct proc_stats *entry = proc_vec_at(defunct_procs, index);
-        handle_zombie(entry, settings, stats, true);
+        const struct proc_entry *entry = proc_vec_at(defunct_procs, index);
+        handle_zombie(entry->pid, entry->ppid, settings, stats, true);
         cbfprintf_enclosed(ANSI_FG_MAGENTA, settings->color_allowed, " -> ",
-                           " ", stdout, "%s", entry->name);
+                           " ", stdout, "%s",
+                           proc_vec_str(defunct_procs, entry->name_off));
         cbfprintf_enclosed(ANSI_FG_MAGENTA, settings->color_allowed,
                            "[PID (Z): ", ", ", stdout, "%d", entry->pid);
         cbfprintf_enclosed(ANSI_FG_RED, settings->color_allowed,
@@ -739,82 +1210,1405 @@ static void prompt_user(const struct proc_vec *defunct_procs,
     }
 }
 
+/* Flags set by the signal handlers of live mode */
+static volatile sig_atomic_t live_resized, live_stopped;
+
 /*!
- * Check running process's states using the `"/proc"` filesystem.
+ * Decode the next key press out of the bytes read from the terminal.
  *
- * @param[in]  settings Pointer to user-specified settings
- * @param[out] stats    Pointer to statistics to update for the zombies found
+ * Several keys may be read at once (e.g. with auto-repeat). The arrow keys
+ * are mapped to `k` and `j`, enter to `s` and other escape sequences are
+ * skipped.
  *
- * @return -1 on error, 0 otherwise
+ * @param[in]  keys Bytes read from the terminal
+ * @param[in]  len  Number of bytes in `keys` (positive)
+ * @param[out] used Number of bytes taken by the key
+ *
+ * @return Decoded key, `0` for a skipped sequence
  */
-static int check_procs(struct zps_settings *settings, struct zps_stats *stats)
+static char live_key(const char *keys, size_t len, size_t *used)
 {
-    assert(settings);
-    assert(stats);
+    assert(keys);
+    assert(len);
+    assert(used);
 
-    struct proc_vec *const defunct_procs = proc_vec();
-    if (!defunct_procs) {
-        return -1;
+    if (keys[0] != '\x1b') {
+        *used = 1;
+        return keys[0] == '\n' ? 's' : keys[0];
+    }
+    size_t i = 1;
+    if (len > 1 && keys[1] == 'O') {
+        /* Cursor keys in the application mode (`ESC O A`) */
+        i = 2;
+    } else if (len > 1 && keys[1] == '[') {
+        /* Control sequence up to its final byte (`ESC [ 1 ; 5 B`) */
+        for (i = 2; i < len && (keys[i] < 0x40 || keys[i] > 0x7e); ++i) {
+        }
+    } else {
+        /* A lone escape */
+        *used = 1;
+        return 0;
+    }
+    if (i >= len) {
+        *used = len;
+        return 0;
     }
+    *used = i + 1;
+    switch (keys[i]) {
+    case 'A':
+        return 'k';
+    case 'B':
+        return 'j';
+    default:
+        return 0;
+    }
+}
 
-    /* Print column titles (header line). */
-    cbfprintf(ANSI_FG_NORMAL, settings->color_allowed, stdout,
-              "%-*s %-*s %-*s %*.*s %s\n", PID_COL_WIDTH, "PID", PPID_COL_WIDTH,
-              "PPID", STATE_COL_WIDTH, "STATE", NAME_COL_WIDTH, NAME_COL_WIDTH,
-              "NAME", "COMMAND");
+/*!
+ * Signal handler of live mode for `SIGWINCH`, `SIGINT` and `SIGTERM`.
+ *
+ * @param[in] sig Received signal
+ *
+ * @return void
+ */
+static void live_on_signal(int sig)
+{
+    if (sig == SIGWINCH) {
+        live_resized = 1;
+    } else {
+        live_stopped = 1;
+    }
+}
 
-    /* Main function logic */
-    proc_iter(defunct_procs, settings, stats);
-    if (settings->signal) {
-        handle_found_zombies(defunct_procs, settings, stats);
+/*!
+ * Compare two process entries by their PPID and PID (for `qsort()`).
+ *
+ * @param[in] a Pointer to the first `proc_entry`
+ * @param[in] b Pointer to the second `proc_entry`
+ *
+ * @return Negative, zero or positive value as `a` is less than, equal to or
+ *         greater than `b`
+ */
+static int proc_entry_cmp_ppid(const void *a, const void *b)
+{
+    const struct proc_entry *const proc_a = a;
+    const struct proc_entry *const proc_b = b;
+
+    if (proc_a->ppid != proc_b->ppid) {
+        return (proc_a->ppid > proc_b->ppid) - (proc_a->ppid < proc_b->ppid);
+    }
+    return (proc_a->pid > proc_b->pid) - (proc_a->pid < proc_b->pid);
+}
+
+/*!
+ * Adapt the screen buffers to the current terminal size.
+ *
+ * The buffers are only replaced once all of them have been allocated, so
+ * the screen keeps its previous size on error.
+ *
+ * @param[in,out] screen Pointer to the screen to resize
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int live_screen_resize(struct live_screen *screen)
+{
+    struct winsize ws = {0};
+
+    assert(screen);
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) || !ws.ws_row || !ws.ws_col) {
+        ws.ws_row = 24;
+        ws.ws_col = 80;
     }
-    if (settings->prompt && proc_vec_size(defunct_procs)) {
-        prompt_user(defunct_procs, settings, stats);
+    const size_t size              = (size_t)ws.ws_row * (ws.ws_col + 1);
+    char *const cur                = calloc(size, 1);
+    char *const prev               = calloc(size, 1);
+    unsigned char *const cur_attr  = malloc(ws.ws_row);
+    unsigned char *const prev_attr = malloc(ws.ws_row);
+    if (!cur || !prev || !cur_attr || !prev_attr) {
+        free(cur);
+        free(prev);
+        free(cur_attr);
+        free(prev_attr);
+        return -1;
     }
 
-    proc_vec_free(defunct_procs);
+    free(screen->cur);
+    free(screen->prev);
+    free(screen->cur_attr);
+    free(screen->prev_attr);
+    screen->cur         = cur;
+    screen->prev        = prev;
+    screen->cur_attr    = cur_attr;
+    screen->prev_attr   = prev_attr;
+    screen->rows        = ws.ws_row;
+    screen->cols        = ws.ws_col;
+    screen->full_redraw = true;
+    memset(screen->cur_attr, LIVE_ROW_NORMAL, screen->rows);
+    memset(screen->prev_attr, LIVE_ROW_NORMAL, screen->rows);
 
     return 0;
 }
 
 /*!
- * Entry point
+ * Write formatted text into a row of the current frame.
+ *
+ * The text is truncated to the width of the terminal.
+ *
+ * @param[out] screen Pointer to the screen to use
+ * @param[in]  row    Index of the row
+ * @param[in]  attr   Display attribute of the row
+ * @param[in]  format Format string specifying the text to write
+ * @param[in]  ...    Variable format string arguments
+ *
+ * @return void
  */
-int main(int argc, char *argv[])
+static void live_screen_row(struct live_screen *screen, int row,
+                            enum live_row_attr attr, const char *format, ...)
 {
-    struct zps_settings settings = {
-        .sig           = 0,
-        .signal        = false,
-        .show_all      = false,
-        .prompt        = false,
-        .quiet         = false,
-        .interactive   = true,
-        .color_allowed = true,
-    };
-    struct zps_stats stats = {
-        .defunct_count  = 0,
-        .signaled_procs = 0,
-    };
-    struct timespec start = {0}, end = {0};
+    va_list vargs;
 
-    clock_gettime(CLOCK_REALTIME, &start);
-    check_interactive(&settings);
-    parse_args(argc, argv, &settings);
-    if (settings.quiet) {
-        silence(stdout);
-        silence(stderr);
+    assert(screen);
+    assert(format);
+
+    if (row < 0 || row >= screen->rows) {
+        return;
     }
-    const int rc = check_procs(&settings, &stats);
-    clock_gettime(CLOCK_REALTIME, &end);
+    va_start(vargs, format);
+    vsnprintf(screen->cur + (size_t)row * (screen->cols + 1), screen->cols + 1,
+              format, vargs);
+    va_end(vargs);
+    screen->cur_attr[row] = attr;
+}
 
-    const double duration_ms = (end.tv_sec - start.tv_sec) * 1e3 +
-                               (end.tv_nsec - start.tv_nsec) * 1e-6;
-    if (stats.signaled_procs) {
-        /* Show signal count and taken time. */
-        fprintf(stdout,
-                "\nParent(s) signaled: %zu/%zu\nElapsed time: %.2f ms\n",
-                stats.signaled_procs, stats.defunct_count, duration_ms);
+/*!
+ * Draw the rows that changed since the previous frame.
+ *
+ * @param[in,out] screen   Pointer to the screen to draw
+ * @param[in]     settings Pointer to user-specified settings (color?)
+ *
+ * @return void
+ */
+static void live_screen_flush(struct live_screen *screen,
+                              const struct zps_settings *settings)
+{
+    assert(screen);
+    assert(settings);
+
+    for (int row = 0; row < screen->rows; ++row) {
+        const size_t offset      = (size_t)row * (screen->cols + 1);
+        const char *const cur    = screen->cur + offset;
+        const char *const prev   = screen->prev + offset;
+        const unsigned char attr = screen->cur_attr[row];
+        if (!screen->full_redraw && attr == screen->prev_attr[row] &&
+            !strcmp(cur, prev)) {
+            continue;
+        }
+        /* Move the cursor to the row and replace its content */
+        fprintf(stdout, "\x1b[%d;1H", row + 1);
+        if (settings->color_allowed && attr != LIVE_ROW_NORMAL) {
+            fprintf(stdout, "\x1b[%dm",
+                    attr == LIVE_ROW_BOLD     ? ANSI_DISPLAY_MODE_BOLD
+                    : attr == LIVE_ROW_ZOMBIE ? ANSI_FG_RED
+                                              : ANSI_DISPLAY_MODE_REVERSE);
+        }
+        fprintf(stdout, "%s\x1b[K", cur);
+        if (settings->color_allowed && attr != LIVE_ROW_NORMAL) {
+            fprintf(stdout, "\x1b[%dm", ANSI_DISPLAY_MODE_NORMAL);
+        }
+    }
+    fflush(stdout);
+
+    /* The current frame becomes the previous one */
+    char *const tmp               = screen->prev;
+    screen->prev                  = screen->cur;
+    screen->cur                   = tmp;
+    unsigned char *const tmp_attr = screen->prev_attr;
+    screen->prev_attr             = screen->cur_attr;
+    screen->cur_attr              = tmp_attr;
+    screen->full_redraw           = false;
+    memset(screen->cur, '\0', (size_t)screen->rows * (screen->cols + 1));
+    memset(screen->cur_attr, LIVE_ROW_NORMAL, screen->rows);
+}
+
+/*!
+ * Render the process list of live mode into the current frame.
+ *
+ * @param[out]    screen   Pointer to the screen to render into
+ * @param[in]     scan     Pointer to the scan state
+ * @param[in]     selected Index of the selected process
+ * @param[in,out] first    Index of the first visible process (scrolling)
+ * @param[in]     message  Status message to show
+ * @param[in]     stats    Pointer to the statistics to show
+ *
+ * @return void
+ */
+static void live_render(struct live_screen *screen,
+                        const struct live_scan *scan, size_t selected,
+                        size_t *first, const char *message,
+                        const struct zps_stats *stats)
+{
+    assert(screen);
+    assert(scan);
+    assert(first);
+    assert(message);
+    assert(stats);
+
+    const size_t list_rows = screen->rows > 3 ? screen->rows - 3 : 0;
+    if (selected < *first) {
+        *first = selected;
+    } else if (list_rows && selected >= *first + list_rows) {
+        *first = selected - list_rows + 1;
+    }
+
+    live_screen_row(screen, 0, LIVE_ROW_BOLD,
+                    "zps v%s - zombies: %zu, processes: %zu, signaled: %zu%s",
+                    VERSION, scan->zombies, scan->shown_scanned,
+                    stats->signaled_procs, scan->active ? " (scanning)" : "");
+    live_screen_row(screen, 1, LIVE_ROW_BOLD, "  %-*s %-*s %-*s %*.*s %s",
+                    PID_COL_WIDTH, "PID", PPID_COL_WIDTH, "PPID",
+                    STATE_COL_WIDTH, "STATE", NAME_COL_WIDTH, NAME_COL_WIDTH,
+                    "NAME", "COMMAND");
+    for (size_t i = 0; i < list_rows; ++i) {
+        const struct proc_entry *const entry =
+            proc_vec_at(scan->shown, *first + i);
+        if (!entry) {
+            break;
+        }
+        const bool is_selected = *first + i == selected;
+        live_screen_row(screen, 2 + i,
+                        is_selected                          ? LIVE_ROW_SELECTED
+                        : entry->state == ZPS_STATE_ZOMBIE ? LIVE_ROW_ZOMBIE
+                                                           : LIVE_ROW_NORMAL,
+                        "%c %-*d %-*d %-*c %*.*s %s", is_selected ? '>' : ' ',
+                        PID_COL_WIDTH, entry->pid, PPID_COL_WIDTH, entry->ppid,
+                        STATE_COL_WIDTH, entry->state, NAME_COL_WIDTH,
+                        NAME_COL_WIDTH,
+                        proc_vec_str(scan->shown, entry->name_off),
+                        proc_vec_str(scan->shown, entry->cmd_off));
+    }
+    live_screen_row(screen, screen->rows - 1, LIVE_ROW_BOLD,
+                    "[j/k] move  [s] signal parent  [r] rescan  [q] quit  %s",
+                    message);
+}
+
+/* Struct for the state of live mode passed to its `zps_scan()` callback */
+struct live_state {
+    const struct zps_settings *settings;
+    struct zps_stats *stats;
+    struct live_screen screen;
+    struct live_scan scan;
+    /* Status message shown in the last row */
+    char message[MAX_BUF_SIZE];
+    /* Index of the selected process and of the first visible one */
+    size_t selected, first;
+    /* Boolean values for drawing the next frame and for leaving live mode */
+    bool redraw, quit;
+    /* Error number of a failed resize of the screen (`0` if none) */
+    int error;
+};
+
+/*!
+ * Draw a frame of live mode if needed and handle the pressed keys.
+ *
+ * @param[in,out] live       Pointer to the state of live mode
+ * @param[in]     timeout_ms Milliseconds to wait for a key press
+ *
+ * @return void
+ */
+static void live_frame(struct live_state *live, int timeout_ms)
+{
+    assert(live);
+
+    const struct zps_settings *const settings = live->settings;
+    struct live_scan *const scan              = &live->scan;
+    if (live_resized) {
+        live_resized = 0;
+        if (live_screen_resize(&live->screen)) {
+            /* Leave live mode with an error */
+            live->error = errno;
+            live->quit  = true;
+            return;
+        }
+        live->redraw = true;
+    }
+    if (live->redraw) {
+        const size_t shown = proc_vec_size(scan->shown);
+        if (live->selected >= shown) {
+            live->selected = shown ? shown - 1 : 0;
+        }
+        live_render(&live->screen, scan, live->selected, &live->first,
+                    live->message, live->stats);
+        live_screen_flush(&live->screen, settings);
+        live->redraw = false;
+    }
+
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return;
+    }
+    char keys[16] = {0};
+    const ssize_t len = read(STDIN_FILENO, keys, sizeof(keys) - 1);
+    if (len <= 0) {
+        return;
+    }
+    live->redraw = true;
+    /* Handle every key of the read, one at a time */
+    for (size_t i = 0, used = 0; i < (size_t)len && !live->quit; i += used) {
+        const size_t shown = proc_vec_size(scan->shown);
+        switch (live_key(keys + i, len - i, &used)) {
+        case 'q':
+            live->quit = true;
+            break;
+        case 'j':
+            live->selected += live->selected + 1 < shown;
+            break;
+        case 'k':
+            live->selected -= live->selected > 0;
+            break;
+        case 'g':
+            live->selected = 0;
+            break;
+        case 'G':
+            live->selected = shown ? shown - 1 : 0;
+            break;
+        case 'r':
+            scan->finished = (struct timespec){0};
+            break;
+        case 's': {
+            const struct proc_entry *const entry =
+                proc_vec_at(scan->shown, live->selected);
+            const int sig = settings->sig ? settings->sig : SIGTERM;
+            const char *const sigabbrev = zps_sig_abbrev(sig);
+            if (!entry || entry->state != ZPS_STATE_ZOMBIE) {
+                snprintf(live->message, sizeof(live->message),
+                         "Not a zombie");
+            } else if (handle_zombie(entry->pid, entry->ppid, settings,
+                                     live->stats, false)) {
+                snprintf(live->message, sizeof(live->message),
+                         "Failed to signal PPID %d: %s", entry->ppid,
+                         strerror(errno));
+            } else {
+                snprintf(live->message, sizeof(live->message),
+                         "Sent SIG%s to PPID %d", sigabbrev ? sigabbrev : "?",
+                         entry->ppid);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/*!
+ * Collect a scanned process for live mode (the `zps_scan()` callback).
+ *
+ * A frame is drawn every `LIVE_SCAN_CHUNK` processes so that key presses are
+ * handled promptly during long scans.
+ *
+ * @param[in]     proc_stats Pointer to the scanned process
+ * @param[in,out] userdata   Pointer to the `live_state`
+ *
+ * @return Non-zero value to stop the scan when leaving live mode
+ */
+static int live_scan_visit(const struct zps_proc *proc_stats, void *userdata)
+{
+    struct live_state *const live = userdata;
+    struct live_scan *const scan  = &live->scan;
+
+    ++scan->scanned;
+    if (live->settings->show_all) {
+        proc_vec_add(scan->pending, proc_stats);
+    } else if (proc_stats->state == ZPS_STATE_ZOMBIE) {
+        /* The command line is only read for the listed processes */
+        struct zps_proc zombie = {0};
+        if (!zps_lookup(scan->ctx, proc_stats->pid, &zombie)) {
+            proc_vec_add(scan->pending, &zombie);
+        }
+    }
+    if (++scan->chunk == LIVE_SCAN_CHUNK) {
+        scan->chunk = 0;
+        live_frame(live, 0);
+    }
+
+    return live->quit || live_stopped;
+}
+
+/*!
+ * Scan the processes for live mode and publish them as the shown ones.
+ *
+ * Frames are drawn during the scan (see `live_scan_visit()`), the last
+ * complete scan is shown until this one has been completed.
+ *
+ * @param[in,out] live Pointer to the state of live mode
+ *
+ * @return void
+ */
+static void live_scan(struct live_state *live)
+{
+    assert(live);
+
+    struct live_scan *const scan   = &live->scan;
+    const struct zps_filter filter = {.skip_cmd = !live->settings->show_all};
+    proc_vec_clear(scan->pending);
+    scan->scanned = 0;
+    scan->chunk   = 0;
+    scan->active  = true;
+    const int rc  = zps_scan(scan->ctx, &filter, live_scan_visit, live);
+    scan->active  = false;
+    live->redraw  = true;
+    clock_gettime(CLOCK_MONOTONIC, &scan->finished);
+    if (rc) {
+        snprintf(live->message, sizeof(live->message), "Failed to read %s: %s",
+                 live->settings->proc_root, strerror(errno));
+        return;
+    }
+    if (live->quit || live_stopped) {
+        return;
+    }
+
+    /* Publish the complete scan */
+    struct proc_vec *const tmp = scan->shown;
+    scan->shown                = scan->pending;
+    scan->pending              = tmp;
+    scan->shown_scanned        = scan->scanned;
+    scan->zombies              = 0;
+    for (size_t i = 0; i < proc_vec_size(scan->shown); ++i) {
+        scan->zombies += proc_vec_at(scan->shown, i)->state == ZPS_STATE_ZOMBIE;
+    }
+    proc_vec_sort(scan->shown, proc_entry_cmp_ppid);
+}
+
+/*!
+ * Show a full-screen process list that is rescanned and redrawn periodically.
+ *
+ * Only the rows that changed since the previous frame are drawn. Frames are
+ * also drawn during the scans so that key presses are handled promptly even
+ * on hosts with a large number of processes.
+ *
+ * @param[in]  settings Pointer to user-specified settings
+ * @param[out] stats    The `signaled_procs` field will be updated
+ *
+ * @return -1 on error, 0 otherwise
+ */
+static int live_mode(const struct zps_settings *settings,
+                     struct zps_stats *stats)
+{
+    struct termios old_termios   = {0}, raw_termios = {0};
+    struct live_state live       = {0};
+    struct live_scan *const scan = &live.scan;
+
+    assert(settings);
+    assert(stats);
+
+    live.settings = settings;
+    live.stats    = stats;
+    live.redraw   = true;
+    if (!(scan->ctx = zps_ctx_new(settings->proc_root, settings->cmd_len))) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to open %s: %s\n", settings->proc_root,
+                 strerror(errno));
+        return -1;
+    }
+    scan->pending = proc_vec();
+    scan->shown   = proc_vec();
+    if (!scan->ctx || !scan->pending || !scan->shown ||
+        tcgetattr(STDIN_FILENO, &old_termios) ||
+        live_screen_resize(&live.screen)) {
+        zps_ctx_free(scan->ctx);
+        proc_vec_free(scan->pending);
+        proc_vec_free(scan->shown);
+        return -1;
+    }
+
+    const struct sigaction action = {.sa_handler = live_on_signal};
+    sigaction(SIGWINCH, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    /* Read key presses unbuffered and switch to the alternate screen */
+    raw_termios = old_termios;
+    raw_termios.c_lflag &= ~(ICANON | ECHO);
+    raw_termios.c_cc[VMIN]  = 0;
+    raw_termios.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw_termios);
+    fprintf(stdout, "\x1b[?1049h\x1b[?25l\x1b[2J");
+
+    const double interval = settings->interval ? settings->interval
+                                               : LIVE_INTERVAL;
+    while (!live.quit && !live_stopped) {
+        /* Start a new scan when it is due */
+        struct timespec now = {0};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const double idle = (now.tv_sec - scan->finished.tv_sec) +
+                            (now.tv_nsec - scan->finished.tv_nsec) * 1e-9;
+        if (idle >= interval) {
+            live_scan(&live);
+        } else {
+            live_frame(&live, (int)((interval - idle) * 1e3) + 1);
+        }
+    }
+
+    /* Restore the terminal */
+    fprintf(stdout, "\x1b[?25h\x1b[?1049l");
+    fflush(stdout);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &old_termios);
+    zps_ctx_free(scan->ctx);
+    proc_vec_free(scan->pending);
+    proc_vec_free(scan->shown);
+    free(live.screen.cur);
+    free(live.screen.prev);
+    free(live.screen.cur_attr);
+    free(live.screen.prev_attr);
+    if (live.error) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to resize the screen: %s\n", strerror(live.error));
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Compare two leaderboard entries by their zombie count (for `qsort()`).
+ *
+ * @param[in] a Pointer to the first `top_entry`
+ * @param[in] b Pointer to the second `top_entry`
+ *
+ * @return Negative, zero or positive value as `a` has more, as many or fewer
+ *         zombies than `b`
+ */
+static int top_entry_cmp_zombies(const void *a, const void *b)
+{
+    const size_t zombies_a = ((const struct top_entry *)a)->zombies;
+    const size_t zombies_b = ((const struct top_entry *)b)->zombies;
+
+    return (zombies_a < zombies_b) - (zombies_a > zombies_b);
+}
+
+/*!
+ * Format a duration in seconds using its two most significant units.
+ *
+ * @param[out] buf     Buffer to write the formatted duration to
+ * @param[in]  bufsiz  Size of `buf`
+ * @param[in]  seconds Duration to format
+ *
+ * @return `buf`
+ */
+static char *format_duration(char *buf, size_t bufsiz, double seconds)
+{
+    const unsigned long secs = seconds > 0 ? (unsigned long)seconds : 0;
+
+    if (secs >= 86400) {
+        snprintf(buf, bufsiz, "%lud%02luh", secs / 86400, secs % 86400 / 3600);
+    } else if (secs >= 3600) {
+        snprintf(buf, bufsiz, "%luh%02lum", secs / 3600, secs % 3600 / 60);
+    } else if (secs >= 60) {
+        snprintf(buf, bufsiz, "%lum%02lus", secs / 60, secs % 60);
+    } else {
+        snprintf(buf, bufsiz, "%lus", secs);
+    }
+    return buf;
+}
+
+/*!
+ * Print the leaderboard of the parents with the most zombies.
+ *
+ * Counts prefixed with `~` are upper bounds since the parent replaced another
+ * one after the leaderboard got full. The shares only include the zombies
+ * that are known to be of the parent, so they are lower bounds then.
+ *
+ * @param[in,out] heap     Pointer to the leaderboard (gets sorted)
+ * @param[in,out] ctx      Pointer to the scan context
+ * @param[in]     settings Pointer to user-specified settings (color?)
+ *
+ * @return void
+ */
+static void print_top(struct top_heap *heap, struct zps_ctx *ctx,
+                      const struct zps_settings *settings)
+{
+    char uptime_buf[64] = {0};
+    double uptime       = 0;
+
+    assert(heap);
+    assert(ctx);
+    assert(settings);
+
+    if (zps_read_file(ctx->dirfd, uptime_buf, sizeof(uptime_buf), NULL,
+                      "uptime") == -1 ||
+        sscanf(uptime_buf, "%lf", &uptime) != 1) {
+        uptime = 0;
+    }
+    const long ticks = sysconf(_SC_CLK_TCK);
+
+    /* The heap order is not needed anymore */
+    qsort(heap->entries, heap->sz, sizeof(*heap->entries),
+          top_entry_cmp_zombies);
+    for (size_t i = 0; i < heap->sz; ++i) {
+        const struct top_entry *const top = &heap->entries[i];
+        struct zps_proc parent            = {.ppid = top->ppid};
+        char count_buf[32] = {0}, age_buf[32] = {0};
+
+        if (zps_lookup(ctx, top->ppid, &parent)) {
+            snprintf(parent.name, sizeof(parent.name), "?");
+            parent.cmd = "";
+        }
+        snprintf(count_buf, sizeof(count_buf), "%s%zu", top->error ? "~" : "",
+                 top->zombies);
+        /* Zombies that are counted for the parent for sure */
+        const size_t known = top->zombies - top->error;
+        format_duration(age_buf, sizeof(age_buf),
+                        ticks > 0 && uptime > 0
+                            ? uptime - (double)top->oldest_starttime / ticks
+                            : 0);
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stdout,
+                 "%-*d %-*s %5.1f%% %-*d %-*s %*.*s %s\n", PPID_COL_WIDTH,
+                 top->ppid, PID_COL_WIDTH, count_buf,
+                 heap->total ? 100.0 * known / heap->total : 0.0,
+                 PID_COL_WIDTH, top->oldest_pid, STATE_COL_WIDTH + 2, age_buf,
+                 NAME_COL_WIDTH, NAME_COL_WIDTH, parent.name, parent.cmd);
+    }
+}
+
+/*!
+ * Compare two process entries by their PID (for `qsort()`).
+ *
+ * @param[in] a Pointer to the first `proc_entry`
+ * @param[in] b Pointer to the second `proc_entry`
+ *
+ * @return Negative, zero or positive value as `a` is less than, equal to or
+ *         greater than `b`
+ */
+static int proc_entry_cmp_pid(const void *a, const void *b)
+{
+    const pid_t pid_a = ((const struct proc_entry *)a)->pid;
+    const pid_t pid_b = ((const struct proc_entry *)b)->pid;
+
+    return (pid_a > pid_b) - (pid_a < pid_b);
+}
+
+/*!
+ * Save the scanned process table as a snapshot file.
+ *
+ * Records are written sorted by PID, followed by the string table that
+ * holds the names and commands (see `struct snapshot_header`). The arena of
+ * the process vector already has the layout of the string table.
+ *
+ * @param[in,out] procs Pointer to the process vector to save (gets sorted)
+ * @param[in]     path  Path of the snapshot file to write
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int snapshot_save(struct proc_vec *procs, const char *path)
+{
+    assert(procs);
+    assert(path);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return -1;
+    }
+    proc_vec_sort(procs, proc_entry_cmp_pid);
+
+    const size_t count                  = proc_vec_size(procs);
+    const struct snapshot_header header = {
+        .magic        = SNAPSHOT_MAGIC,
+        .version      = SNAPSHOT_VERSION,
+        .record_size  = sizeof(struct snapshot_record),
+        .count        = count,
+        .records_off  = sizeof(header),
+        .strings_off  = sizeof(header) + count * sizeof(struct snapshot_record),
+        .strings_size = procs->arena_sz,
+        .timestamp    = time(NULL),
+    };
+    bool failed = fwrite(&header, sizeof(header), 1, file) != 1;
+
+    for (size_t i = 0; i < count && !failed; ++i) {
+        const struct proc_entry *const entry = proc_vec_at(procs, i);
+        const struct snapshot_record record  = {
+            .pid      = entry->pid,
+            .ppid     = entry->ppid,
+            .name_off = entry->name_off,
+            .cmd_off  = entry->cmd_off,
+            .state    = entry->state,
+        };
+        failed = fwrite(&record, sizeof(record), 1, file) != 1;
+    }
+    failed = failed || fwrite(procs->arena, procs->arena_sz, 1, file) != 1;
+    failed = fclose(file) == EOF || failed;
+
+    return failed ? -1 : 0;
+}
+
+/*!
+ * Map a snapshot file into memory and validate its layout.
+ *
+ * The `snapshot_close()` function should be called on `snap` in order to
+ * unmap the file.
+ *
+ * @param[in]  path Path of the snapshot file to open
+ * @param[out] snap Pointer to the mapping to initialize
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int snapshot_open(const char *path, struct snapshot_map *snap)
+{
+    struct stat st = {0};
+
+    assert(path);
+    assert(snap);
+
+    const int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(*snap->header)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return -1;
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    const struct snapshot_header *const header = addr;
+    const size_t size                          = st.st_size;
+    const bool valid =
+        !memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) &&
+        header->version == SNAPSHOT_VERSION &&
+        header->record_size == sizeof(struct snapshot_record) &&
+        header->records_off == sizeof(*header) &&
+        header->count <= (size - header->records_off) / header->record_size &&
+        header->strings_off ==
+            header->records_off + header->count * header->record_size &&
+        header->strings_size > 0 &&
+        header->strings_size <= size - header->strings_off &&
+        ((const char *)addr)[header->strings_off + header->strings_size - 1] ==
+            '\0';
+    if (!valid) {
+        munmap(addr, size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    snap->header  = header;
+    snap->records = (const struct snapshot_record *)((const char *)addr +
+                                                     header->records_off);
+    snap->strings = (const char *)addr + header->strings_off;
+    snap->size    = size;
+
+    return 0;
+}
+
+/*!
+ * Unmap a snapshot file opened by `snapshot_open()`.
+ *
+ * @param[in,out] snap Pointer to the mapping to release
+ *
+ * @return void
+ */
+static void snapshot_close(struct snapshot_map *snap)
+{
+    assert(snap);
+
+    if (snap->header) {
+        munmap((void *)snap->header, snap->size);
+    }
+    snap->header = NULL;
+}
+
+/*!
+ * Return the string at `off` in the string table of `snap`.
+ *
+ * @param[in] snap Pointer to the mapped snapshot
+ * @param[in] off  Offset of the string in the string table
+ *
+ * @return Pointer to the null-terminated string (empty if out of bounds)
+ */
+static const char *snapshot_str(const struct snapshot_map *snap, uint32_t off)
+{
+    assert(snap);
+
+    return off < snap->header->strings_size ? snap->strings + off : "";
+}
+
+/*!
+ * Print a single line of the snapshot comparison.
+ *
+ * @param[in] mark      Character indicating the kind of difference
+ * @param[in] color     Color to print the line with
+ * @param[in] snap      Pointer to the snapshot that contains `record`
+ * @param[in] record    Pointer to the record to print
+ * @param[in] old_state Previous state of the process (`'\0'` if not changed)
+ * @param[in] settings  Pointer to user-specified settings (color?)
+ *
+ * @return void
+ */
+static void snapshot_print_diff(char mark, enum ansi_fg_color_code color,
+                                const struct snapshot_map *snap,
+                                const struct snapshot_record *record,
+                                char old_state,
+                                const struct zps_settings *settings)
+{
+    char state[STATE_COL_WIDTH + 1] = {0};
+
+    if (old_state) {
+        snprintf(state, sizeof(state), "%c->%c", old_state, record->state);
+    } else {
+        state[0] = record->state;
+    }
+    cfprintf(color, settings->color_allowed, stdout,
+             "%c %-*d %-*d %-*s %*.*s %s\n", mark, PID_COL_WIDTH, record->pid,
+             PPID_COL_WIDTH, record->ppid, STATE_COL_WIDTH, state,
+             NAME_COL_WIDTH, NAME_COL_WIDTH,
+             snapshot_str(snap, record->name_off),
+             snapshot_str(snap, record->cmd_off));
+}
+
+/*!
+ * Compare two snapshot files and print new, vanished and changed processes.
+ *
+ * Both files are mapped into memory and walked with a single linear merge
+ * over their PID-sorted records. A PID that belongs to a different parent or
+ * name in the new snapshot is reported as vanished and new (PID reuse).
+ *
+ * @param[in] settings Pointer to user-specified settings (diff paths)
+ *
+ * @return `-1` on error, otherwise `0` is returned
+ */
+static int snapshot_diff(const struct zps_settings *settings)
+{
+    struct snapshot_map old_snap = {0}, new_snap = {0};
+
+    assert(settings);
+
+    for (size_t i = 0; i < 2; ++i) {
+        struct snapshot_map *const snap = i ? &new_snap : &old_snap;
+        if (snapshot_open(settings->diff_paths[i], snap)) {
+            cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                     "Failed to open snapshot %s: %s\n",
+                     settings->diff_paths[i], strerror(errno));
+            snapshot_close(&old_snap);
+            return -1;
+        }
+    }
+
+    cbfprintf(ANSI_FG_NORMAL, settings->color_allowed, stdout,
+              "  %-*s %-*s %-*s %*.*s %s\n", PID_COL_WIDTH, "PID",
+              PPID_COL_WIDTH, "PPID", STATE_COL_WIDTH, "STATE",
+              NAME_COL_WIDTH, NAME_COL_WIDTH, "NAME", "COMMAND");
+
+    const size_t old_count = old_snap.header->count;
+    const size_t new_count = new_snap.header->count;
+    size_t new_procs = 0, vanished_procs = 0, changed_procs = 0;
+    bool sorted = true;
+    for (size_t i = 0, j = 0; sorted && (i < old_count || j < new_count);) {
+        const struct snapshot_record *const old_rec =
+            i < old_count ? &old_snap.records[i] : NULL;
+        const struct snapshot_record *const new_rec =
+            j < new_count ? &new_snap.records[j] : NULL;
+        sorted = (!old_rec || !i || old_rec[-1].pid < old_rec->pid) &&
+                 (!new_rec || !j || new_rec[-1].pid < new_rec->pid);
+
+        if (!new_rec || (old_rec && old_rec->pid < new_rec->pid)) {
+            snapshot_print_diff('-', ANSI_FG_RED, &old_snap, old_rec, '\0',
+                                settings);
+            ++vanished_procs;
+            ++i;
+        } else if (!old_rec || new_rec->pid < old_rec->pid) {
+            snapshot_print_diff('+', ANSI_FG_GREEN, &new_snap, new_rec, '\0',
+                                settings);
+            ++new_procs;
+            ++j;
+        } else {
+            if (old_rec->ppid != new_rec->ppid ||
+                strcmp(snapshot_str(&old_snap, old_rec->name_off),
+                       snapshot_str(&new_snap, new_rec->name_off))) {
+                snapshot_print_diff('-', ANSI_FG_RED, &old_snap, old_rec,
+                                    '\0', settings);
+                snapshot_print_diff('+', ANSI_FG_GREEN, &new_snap, new_rec,
+                                    '\0', settings);
+                ++vanished_procs;
+                ++new_procs;
+            } else if (old_rec->state != new_rec->state) {
+                snapshot_print_diff('~', ANSI_FG_YELLOW, &new_snap, new_rec,
+                                    old_rec->state, settings);
+                ++changed_procs;
+            }
+            ++i;
+            ++j;
+        }
+    }
+
+    snapshot_close(&old_snap);
+    snapshot_close(&new_snap);
+    if (!sorted) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Snapshot records are not sorted by PID\n");
+        return -1;
+    }
+    fprintf(stdout, "\nNew: %zu\nVanished: %zu\nChanged: %zu\n", new_procs,
+            vanished_procs, changed_procs);
+
+    return 0;
+}
+
+/*!
+ * Update the leak table with the found zombies and report leaking parents.
+ *
+ * @param[out] leaks         Pointer to the leak table to update
+ * @param[in]  ctx           Pointer to the scan context
+ * @param[in]  defunct_procs Pointer to the spill of the zombies
+ * @param[in]  minutes       Time passed since the previous iteration
+ * @param[in]  settings      Pointer to user-specified settings (leak rate)
+ *
+ * @return void
+ */
+static void track_leaks(struct leak_table *leaks, const struct zps_ctx *ctx,
+                        struct proc_spill *defunct_procs, double minutes,
+                        const struct zps_settings *settings)
+{
+    assert(leaks);
+    assert(ctx);
+    assert(defunct_procs);
+    assert(settings);
+
+    proc_spill_rewind(defunct_procs);
+    for (const struct proc_vec *chunk;
+         (chunk = proc_spill_next(defunct_procs));) {
+        for (size_t i = 0, sz = proc_vec_size(chunk); i < sz; ++i) {
+            leak_table_count(leaks, proc_vec_at(chunk, i)->ppid, ctx->dirfd);
+        }
+    }
+    leak_table_update(leaks, minutes);
+
+    for (size_t i = 0; i < leaks->sz; ++i) {
+        const struct leak_entry *const entry = &leaks->entries[i];
+        if (entry->rate > settings->leak_rate) {
+            cfprintf(ANSI_FG_YELLOW, settings->color_allowed, stdout,
+                     "\nZombie leak: PPID %d (%zu zombies, %+.2f/min)\n",
+                     entry->ppid, entry->zombies, entry->rate);
+        }
+    }
+}
+
+/*!
+ * Print the time spent in each phase and the related counters.
+ *
+ * @param[in] perf        Pointer to the measurements
+ * @param[in] duration_ms Total time of the iteration
+ * @param[in] settings    Pointer to user-specified settings (color?)
+ *
+ * @return void
+ */
+static void print_perf(const struct zps_perf *perf, double duration_ms,
+                       const struct zps_settings *settings)
+{
+    static const char *const phase_names[ZPS_PHASE_COUNT] = {
+        [ZPS_PHASE_ENUMERATE] = "enumerate", [ZPS_PHASE_OPEN] = "open",
+        [ZPS_PHASE_READ] = "read",           [ZPS_PHASE_PARSE] = "parse",
+        [ZPS_PHASE_FILTER] = "filter",       [ZPS_PHASE_OUTPUT] = "output",
+        [ZPS_PHASE_SIGNAL] = "signal",
+    };
+
+    assert(perf);
+    assert(settings);
+
+    cbfprintf(ANSI_FG_NORMAL, settings->color_allowed, stdout,
+              "\n%-*s %12s %10s %10s\n", NAME_COL_WIDTH, "PHASE", "TIME (ms)",
+              "CALLS", "NS/CALL");
+    for (size_t i = 0; i < ZPS_PHASE_COUNT; ++i) {
+        fprintf(stdout, "%-*s %12.3f %10zu %10.0f\n", NAME_COL_WIDTH,
+                phase_names[i], perf->phase_ns[i] * 1e-6, perf->phase_calls[i],
+                perf->phase_calls[i]
+                    ? (double)perf->phase_ns[i] / perf->phase_calls[i]
+                    : 0.0);
+    }
+    fprintf(stdout,
+            "%-*s %12.3f\n\n"
+            "Syscalls:          %zu\n"
+            "Bytes read:        %zu\n"
+            "Kernel threads:    %zu\n"
+            "Vanished:          %zu\n",
+            NAME_COL_WIDTH, "total", duration_ms, perf->syscalls,
+            perf->bytes_read, perf->kthreads, perf->vanished);
+}
+
+/* Struct for the state of `count_visit()` */
+struct count_state {
+    size_t zombies;
+    /* Distinct parents of the counted zombies */
+    struct pid_map *parents;
+    /* Number of zombies to stop the scan above */
+    double threshold;
+    /* Boolean value for a failed allocation */
+    bool failed;
+};
+
+/*!
+ * Count a scanned zombie and its parent (the `zps_scan()` callback of the
+ * count-only mode).
+ *
+ * @param[in]     proc_stats Pointer to the scanned zombie
+ * @param[in,out] userdata   Pointer to the `count_state`
+ *
+ * @return `1` to stop the scan once the threshold is exceeded (or on error),
+ *         otherwise `0` is returned
+ */
+static int count_visit(const struct zps_proc *proc_stats, void *userdata)
+{
+    struct count_state *const state = userdata;
+
+    ++state->zombies;
+    if (!pid_map_find(state->parents, proc_stats->ppid) &&
+        !pid_map_put(state->parents, proc_stats->ppid, 0)) {
+        /* Move the parents to a map twice as large */
+        if (!pid_map_grow(&state->parents)) {
+            state->failed = true;
+            return 1;
+        }
+        pid_map_put(state->parents, proc_stats->ppid, 0);
+    }
+
+    return state->zombies > state->threshold;
+}
+
+/*!
+ * Count the zombies and their distinct parents and print the totals in a
+ * single line.
+ *
+ * Only the beginning of the stat files is read and nothing is stored or
+ * formatted per process. The scan stops as soon as the threshold is
+ * exceeded, so the totals are lower bounds then.
+ *
+ * @param[in,out] ctx      Pointer to the scan context
+ * @param[in]     settings Pointer to user-specified settings (threshold?)
+ * @param[out]    stats    Pointer to the statistics (for `--stats`)
+ *
+ * @return `-1` on error, `1` if the threshold is exceeded, otherwise `0` is
+ *         returned
+ */
+static int count_mode(struct zps_ctx *ctx, const struct zps_settings *settings,
+                      struct zps_stats *stats)
+{
+    static const struct zps_filter filter = {
+        .zombies_only = true,
+        .state_only   = true,
+    };
+    struct timespec start = {0}, end = {0};
+
+    assert(ctx);
+    assert(settings);
+    assert(stats);
+
+    struct count_state state = {
+        .zombies   = 0,
+        .parents   = pid_map(COUNT_PARENTS_SIZE),
+        .threshold = settings->threshold,
+        .failed    = false,
+    };
+    if (!state.parents) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const int rc = zps_scan(ctx, &filter, count_visit, &state);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (rc || state.failed) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to count the zombies: %s\n", strerror(errno));
+        pid_map_free(state.parents);
+        return -1;
+    }
+    fprintf(stdout, "zombies: %zu parents: %zu\n", state.zombies,
+            state.parents->sz);
+    if (settings->show_stats) {
+        print_perf(&stats->perf,
+                   (end.tv_sec - start.tv_sec) * 1e3 +
+                       (end.tv_nsec - start.tv_nsec) * 1e-6,
+                   settings);
+    }
+    pid_map_free(state.parents);
+
+    return state.zombies > state.threshold;
+}
+
+/*!
+ * Check running process's states using the `"/proc"` filesystem.
+ *
+ * @param[in,out] ctx      Pointer to the scan context
+ * @param[in]     settings Pointer to user-specified settings
+ * @param[out]    stats    Pointer to statistics to update for the zombies
+ *                         found
+ * @param[in,out] leaks    Pointer to the leak table to update, may be `NULL`
+ * @param[in]     minutes  Time passed since the previous iteration
+ *
+ * @return -1 on error, 0 otherwise
+ */
+static int check_procs(struct zps_ctx *ctx, struct zps_settings *settings,
+                       struct zps_stats *stats, struct leak_table *leaks,
+                       double minutes)
+{
+    assert(ctx);
+    assert(settings);
+    assert(stats);
+
+    /* Streaming mode signals the parents right away instead, as does the
+     * leaderboard since it does not know every parent */
+    struct proc_spill *defunct_procs = NULL;
+    struct pid_map *parents          = NULL;
+    if (settings->stream || (settings->top && settings->signal)
+            ? !(parents = pid_map(STREAM_PARENTS_SIZE))
+            : !(defunct_procs =
+                    proc_spill((size_t)settings->max_memory << 20))) {
+        return -1;
+    }
+    struct proc_vec *all_procs = NULL;
+    struct top_heap *top       = NULL;
+    if ((settings->save_path && !(all_procs = proc_vec())) ||
+        (settings->top && !(top = top_heap(settings->top)))) {
+        proc_vec_free(all_procs);
+        pid_map_free(parents);
+        proc_spill_free(defunct_procs);
+        return -1;
+    }
+
+    /* Print column titles (header line). */
+    if (top) {
+        cbfprintf(ANSI_FG_NORMAL, settings->color_allowed, stdout,
+                  "%-*s %-*s %-6s %-*s %-*s %*.*s %s\n", PPID_COL_WIDTH,
+                  "PPID", PID_COL_WIDTH, "ZOMBIES", "SHARE", PID_COL_WIDTH,
+                  "OLDEST", STATE_COL_WIDTH + 2, "AGE", NAME_COL_WIDTH,
+                  NAME_COL_WIDTH, "NAME", "COMMAND");
+    } else {
+        cbfprintf(ANSI_FG_NORMAL, settings->color_allowed, stdout,
+                  "%-*s %-*s %-*s %*.*s %s\n", PID_COL_WIDTH, "PID",
+                  PPID_COL_WIDTH, "PPID", STATE_COL_WIDTH, "STATE",
+                  NAME_COL_WIDTH, NAME_COL_WIDTH, "NAME", "COMMAND");
+    }
+
+    /* Main function logic */
+    if (settings->policy) {
+        policy_next_scan(settings->policy);
+    }
+    int rc = 0;
+    if (proc_iter(ctx, defunct_procs, &parents, all_procs, top,
+                  proc_iter_select(settings), settings, stats)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to read %s: %s\n", settings->proc_root,
+                 strerror(errno));
+        rc = -1;
+    }
+    if (top) {
+        print_top(top, ctx, settings);
+    }
+    if (all_procs && snapshot_save(all_procs, settings->save_path)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to save snapshot %s: %s\n", settings->save_path,
+                 strerror(errno));
+        rc = -1;
+    }
+    if (leaks) {
+        track_leaks(leaks, ctx, defunct_procs, minutes, settings);
+    }
+    if (settings->signal && defunct_procs) {
+        /* Only a single chunk without a memory budget (as for prompting) */
+        proc_spill_rewind(defunct_procs);
+        for (const struct proc_vec *chunk;
+             (chunk = proc_spill_next(defunct_procs));) {
+            handle_found_zombies(chunk, leaks, settings, stats);
+        }
+    }
+    if (settings->prompt && proc_vec_size(defunct_procs->chunk)) {
+        prompt_user(defunct_procs->chunk, settings, stats);
+    }
+    if (defunct_procs && defunct_procs->failed) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to spill zombies to a temporary file\n");
+        rc = -1;
+    }
+    /* Group commit of the signals sent during the scan */
+    if (settings->journal && journal_commit(settings->journal)) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to write journal %s: %s\n", settings->journal_path,
+                 strerror(errno));
+        rc = -1;
+    }
+    if (settings->journal && settings->journal->error) {
+        cfprintf(ANSI_FG_RED, settings->color_allowed, stderr,
+                 "Failed to record a signal in journal %s: %s\n",
+                 settings->journal_path, strerror(settings->journal->error));
+        settings->journal->error = 0;
+        rc = -1;
+    }
+
+    top_heap_free(top);
+    proc_vec_free(all_procs);
+    pid_map_free(parents);
+    proc_spill_free(defunct_procs);
+
+    return rc;
+}
+
+/*!
+ * Entry point
+ */
+int main(int argc, char *argv[])
+{
+    struct zps_settings settings = {
+        .sig           = 0,
+        .signal        = false,
+        .show_all      = false,
+        .prompt        = false,
+        .quiet         = false,
+        .interactive   = true,
+        .color_allowed = true,
+        .live          = false,
+        .cmd_len       = CMD_DEFAULT_LEN,
+        .show_stats    = false,
+        .proc_root     = ZPS_PROC_FILESYSTEM,
+        .interval      = 0,
+        .leak_rate     = INFINITY,
+        .top           = 0,
+        .max_memory    = 0,
+        .budget        = INFINITY,
+        .count         = false,
+        .bpf           = false,
+        .threshold     = INFINITY,
+        .save_path     = NULL,
+        .diff_paths    = {NULL, NULL},
+        .policy_path   = NULL,
+        .policy        = NULL,
+        .journal_path  = NULL,
+        .journal       = NULL,
+    };
+    struct zps_stats stats = {
+        .defunct_count  = 0,
+        .signaled_procs = 0,
+    };
+    struct timespec start = {0}, end = {0}, prev = {0};
+    struct leak_table *leaks = NULL;
+    struct zps_ctx *ctx      = NULL;
+    struct zps_pace pace     = {0};
+
+    check_interactive(&settings);
+    parse_args(argc, argv, &settings);
+    if (settings.diff_paths[0]) {
+        return snapshot_diff(&settings) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    if (settings.live) {
+        return live_mode(&settings, &stats) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    if (settings.quiet) {
+        silence(stdout);
+        silence(stderr);
+    }
+    if (!(ctx = zps_ctx_new(settings.proc_root, settings.cmd_len))) {
+        cfprintf(ANSI_FG_RED, settings.color_allowed, stderr,
+                 "Failed to open %s: %s\n", settings.proc_root,
+                 strerror(errno));
+        return EXIT_FAILURE;
+    }
+    zps_ctx_set_perf(ctx, settings.show_stats ? &stats.perf : NULL);
+    if (settings.budget != INFINITY) {
+        pace.share = settings.budget / 100;
+        zps_ctx_set_pace(ctx, &pace);
+        lower_priority();
+    }
+    /* Find the zombies in the kernel if requested (reads `/proc` otherwise) */
+    if (settings.bpf && zps_ctx_use_bpf(ctx)) {
+        cfprintf(ANSI_FG_YELLOW, settings.color_allowed, stderr,
+                 "Failed to load the BPF iterator (%s), reading %s\n",
+                 strerror(errno), settings.proc_root);
+    }
+    if (settings.count) {
+        const int rc = count_mode(ctx, &settings, &stats);
+        zps_ctx_free(ctx);
+        return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    if (settings.policy_path) {
+        size_t line = 0;
+        settings.policy =
+            policy_load(settings.policy_path, settings.proc_root, &line);
+        if (!settings.policy) {
+            if (line) {
+                cfprintf(ANSI_FG_RED, settings.color_allowed, stderr,
+                         "Invalid policy %s (line %zu)\n",
+                         settings.policy_path, line);
+            } else {
+                cfprintf(ANSI_FG_RED, settings.color_allowed, stderr,
+                         "Failed to load policy %s\n", settings.policy_path);
+            }
+            zps_ctx_free(ctx);
+            return EXIT_FAILURE;
+        }
+    }
+    if (settings.journal_path &&
+        !(settings.journal = journal_open(settings.journal_path, ctx->dirfd))) {
+        cfprintf(ANSI_FG_RED, settings.color_allowed, stderr,
+                 "Failed to open journal %s: %s\n", settings.journal_path,
+                 strerror(errno));
+        policy_free(settings.policy);
+        zps_ctx_free(ctx);
+        return EXIT_FAILURE;
+    }
+    if (settings.leak_rate != INFINITY && !(leaks = leak_table())) {
+        journal_close(settings.journal);
+        policy_free(settings.policy);
+        zps_ctx_free(ctx);
+        return EXIT_FAILURE;
+    }
+
+    int rc = 0;
+    for (;;) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        const double minutes = ((start.tv_sec - prev.tv_sec) +
+                                (start.tv_nsec - prev.tv_nsec) * 1e-9) /
+                               60;
+        prev = start;
+        rc   = check_procs(ctx, &settings, &stats, leaks, minutes);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        const double duration_ms = (end.tv_sec - start.tv_sec) * 1e3 +
+                                   (end.tv_nsec - start.tv_nsec) * 1e-6;
+        if (stats.signaled_procs) {
+            /* Show signal count and taken time. */
+            fprintf(stdout,
+                    "\nParent(s) signaled: %zu/%zu\nElapsed time: %.2f ms\n",
+                    stats.signaled_procs, stats.defunct_count, duration_ms);
+        }
+        if (settings.budget != INFINITY && pace.wall_ns) {
+            /* Show the achieved overhead of the paced scan. */
+            fprintf(stdout,
+                    "\nCPU budget: %.2f%% used (%.2f%% allowed), "
+                    "%.2f ms slept\n",
+                    100.0 * pace.cpu_ns / pace.wall_ns, settings.budget,
+                    pace.sleep_ns * 1e-6);
+        }
+        if (settings.show_stats) {
+            print_perf(&stats.perf, duration_ms, &settings);
+        }
+        if (rc || !settings.interval) {
+            break;
+        }
+
+        /* Wait for the next iteration */
+        fflush(stdout);
+        stats = (struct zps_stats){0};
+        const struct timespec interval = {
+            .tv_sec  = (time_t)settings.interval,
+            .tv_nsec = (long)((settings.interval - (time_t)settings.interval) *
+                              1e9),
+        };
+        nanosleep(&interval, NULL);
     }
+    leak_table_free(leaks);
+    journal_close(settings.journal);
+    policy_free(settings.policy);
+    zps_ctx_free(ctx);
 
     return rc ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -19,48 +19,88 @@
 #define ZPS_H
 
 #include <assert.h>
+#include <dirent.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
+#include <time.h>
+
+#include "libzps.h"
 
 /* Version number string */
 #define VERSION "2.0.0"
 
 #define DELIMS ", \n"
 
-/* PID of `init` */
-#define INIT_PID 1
-/* PID of `kthreadd` */
-#define KTHREADD_PID 2
-
-/* Maximum length of userland process names (incl. '\0') */
-#define TASK_COMM_LEN 16
-/* We will truncate the cmdline string (incl. '\0') */
-#define CMD_MAX_LEN 32
-
 /* Formatting widths for our columns */
 #define PID_COL_WIDTH   10
 #define PPID_COL_WIDTH  PID_COL_WIDTH
 #define STATE_COL_WIDTH 5
-#define NAME_COL_WIDTH  (TASK_COMM_LEN - 1)
+#define NAME_COL_WIDTH  (ZPS_TASK_COMM_LEN - 1)
 
-/* `/proc` filesystem */
-#define PROC_FILESYSTEM "/proc"
 /* PID status file */
 #define STAT_FILE "stat"
 /* PID command file */
 #define CMD_FILE "cmdline"
 
+/* Length the listed command lines are truncated to by default */
+#define CMD_DEFAULT_LEN 31
+
 /* Fixed buffer size */
 #define MAX_BUF_SIZE 4096
+/* Size of the buffer for the directory entries of `/proc` */
+#define DENTS_BUF_SIZE 32768
+/* Bytes of `"/proc/<pid>/stat"` read for the state and the parent only */
+#define STAT_PREFIX_SIZE 128
+
+/* Maximum number of PIDs on Linux (include/linux/threads.h) */
+#ifndef PID_MAX_LIMIT
+#define PID_MAX_LIMIT (4 * 1024 * 1024)
+#endif
+
+/* Maximum number of zombie parents tracked for leak detection */
+#define LEAK_TABLE_SIZE 4096
+/* Smoothing factor of the zombie growth rate average (0, 1] */
+#define LEAK_EWMA_ALPHA 0.3
+
+/* Number of processes scanned between two frames in live mode */
+#define LIVE_SCAN_CHUNK 2048
+/* Seconds between complete scans in live mode (unless `-w` is given) */
+#define LIVE_INTERVAL 1.0
+
+/* Magic bytes at the start of a snapshot file (incl. '\0') */
+#define SNAPSHOT_MAGIC "ZPSSNAP"
+/* Version of the snapshot file layout */
+#define SNAPSHOT_VERSION 1
+
+/* Maximum number of signals of an escalating policy rule */
+#define POLICY_MAX_SIGNALS 8
+/* Maximum number of parents whose policy decision is cached */
+#define POLICY_STATE_SIZE 4096
+
+/* CPU time of a slice of a paced scan to aim for (in nanoseconds) */
+#define PACE_SLICE_NS 1000000
+/* Maximum number of processes in a slice of a paced scan */
+#define PACE_SLICE_MAX 4096
 
-/* Status file entry of zombie state */
-#define STATE_ZOMBIE 'Z'
+/* Initial number of distinct parents counted in the count-only mode */
+#define COUNT_PARENTS_SIZE 1024
+/* Initial number of parents remembered by the streaming reap mode */
+#define STREAM_PARENTS_SIZE 16384
+
+/* Size at which the journal file is rotated to `<file>.1` (in bytes) */
+#define JOURNAL_MAX_SIZE (16 * 1024 * 1024)
+/* Initial capacity of the buffered journal records (in bytes) */
+#define JOURNAL_BUF_SIZE 4096
 
 /* Enum for relevant ANSI SGR display modes */
 enum ansi_display_mode_code {
-    ANSI_DISPLAY_MODE_NORMAL = 0,
-    ANSI_DISPLAY_MODE_BOLD   = 1,
+    ANSI_DISPLAY_MODE_NORMAL  = 0,
+    ANSI_DISPLAY_MODE_BOLD    = 1,
+    ANSI_DISPLAY_MODE_REVERSE = 7,
 };
 
 /* Enum for the different standard ANSI SGR color options */
@@ -76,6 +116,32 @@ enum ansi_fg_color_code {
     ANSI_FG_WHITE   = 37,
 };
 
+/* Enum for the actions of a policy rule */
+enum policy_action {
+    /* Never signal the parent */
+    POLICY_IGNORE = 0,
+    /* Signal the parent with the given signal */
+    POLICY_SIGNAL,
+    /* Use the next signal on every consecutive scan the parent has zombies */
+    POLICY_ESCALATE,
+};
+
+/* Enum for the process attributes a policy rule can match */
+enum policy_key {
+    POLICY_KEY_NAME = 0,
+    POLICY_KEY_EXE,
+    POLICY_KEY_CGROUP,
+    POLICY_KEY_UID,
+};
+
+/* Enum for the display attributes of a row in live mode */
+enum live_row_attr {
+    LIVE_ROW_NORMAL = 0,
+    LIVE_ROW_BOLD,
+    LIVE_ROW_ZOMBIE,
+    LIVE_ROW_SELECTED,
+};
+
 /* Struct for keeping track of the `zps` CLI options */
 struct zps_settings {
     /* Signal to use */
@@ -92,6 +158,65 @@ struct zps_settings {
     bool interactive;
     /* Boolean value for colored output */
     bool color_allowed;
+    /* Boolean value for the interactive full-screen mode */
+    bool live;
+    /* Boolean value for signaling the parents while scanning */
+    bool stream;
+    /* Maximum length of the shown command lines */
+    long cmd_len;
+    /* Boolean value for reporting the time spent in each phase */
+    bool show_stats;
+    /* Path of the `/proc` filesystem to read the processes from */
+    const char *proc_root;
+    /* Seconds to wait between repeated scans (`0` to scan once) */
+    double interval;
+    /* Zombie growth rate (per minute) for a parent to be flagged as leaking
+     * (`INFINITY` for no leak detection) */
+    double leak_rate;
+    /* Number of zombie parents to show in the leaderboard (`0` to list) */
+    long top;
+    /* Memory budget of the found zombies (in MiB), `0` for none */
+    long max_memory;
+    /* Share of a CPU the scans may use (in percent), `INFINITY` for no
+     * pacing */
+    double budget;
+    /* Boolean value for only counting the zombies and their parents */
+    bool count;
+    /* Boolean value for finding the zombies with the BPF task iterator */
+    bool bpf;
+    /* Number of zombies above which the count fails (`INFINITY` for none) */
+    double threshold;
+    /* Path to save the scanned process table to */
+    const char *save_path;
+    /* Paths of the snapshots to compare (old, new) */
+    const char *diff_paths[2];
+    /* Path of the policy file to load */
+    const char *policy_path;
+    /* Loaded policy deciding the signal per parent, `NULL` if none */
+    struct policy *policy;
+    /* Path of the journal file to append the sent signals to */
+    const char *journal_path;
+    /* Open journal, `NULL` if none */
+    struct journal *journal;
+};
+
+/* Struct for the reusable state of `zps_scan()` */
+struct zps_ctx {
+    /* Open `/proc` directory (rewound for every scan) */
+    DIR *dir;
+    /* File descriptor of `dir` to open the process files relative to */
+    int dirfd;
+    /* Buffer for reading the command lines */
+    char *cmd_buf;
+    size_t cmd_bufsiz;
+    /* Phase measurements, `NULL` if disabled */
+    struct zps_perf *perf;
+    /* Loaded task iterator to find the zombies with, `NULL` if not used */
+    struct zps_bpf *bpf;
+    /* Pacing of the scans, `NULL` if disabled */
+    struct zps_pace *pace;
+    /* Number of processes scanned between two pacing sleeps (adaptive) */
+    size_t pace_slice;
 };
 
 /* Struct for keeping track of the zombies */
@@ -100,52 +225,342 @@ struct zps_stats {
     size_t defunct_count;
     /* Number of signaled processes */
     size_t signaled_procs;
+    /* Phase measurements (only updated with `--stats`) */
+    struct zps_perf perf;
+};
+
+/* Struct for tracking the zombie growth of a single parent process */
+struct leak_entry {
+    /* PID of the parent */
+    pid_t ppid;
+    /* Start time of the parent (guards against PID reuse) */
+    unsigned long long starttime;
+    /* Iteration in which `zombies` was counted */
+    unsigned long generation;
+    /* Number of zombies in the last counted iteration */
+    size_t zombies;
+    /* Number of zombies in the iteration before */
+    size_t prev_zombies;
+    /* Smoothed zombie growth rate (per minute) */
+    double rate;
+};
+
+/*
+ * Header of a snapshot file.
+ *
+ * The file is laid out as the header, followed by `count` records sorted by
+ * PID, followed by a table of null-terminated strings which the records refer
+ * to by offset. Offset `0` always holds the empty string. All fields are
+ * stored in host byte order so the file can be used directly via `mmap()`.
+ */
+struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t records_off;
+    uint64_t strings_off;
+    uint64_t strings_size;
+    int64_t timestamp;
+};
+
+/* Fixed-size snapshot entry of a single process */
+struct snapshot_record {
+    int32_t pid;
+    int32_t ppid;
+    uint32_t name_off;
+    uint32_t cmd_off;
+    char state;
+    char padding[3];
+};
+
+/* Struct for a read-only snapshot file mapped into memory */
+struct snapshot_map {
+    const struct snapshot_header *header;
+    const struct snapshot_record *records;
+    const char *strings;
+    size_t size;
+};
+
+/* Struct for the aggregated zombies of a single parent process */
+struct top_entry {
+    /* PID of the parent */
+    pid_t ppid;
+    /* PID of the oldest zombie */
+    pid_t oldest_pid;
+    /* Start time of the oldest zombie */
+    unsigned long long oldest_starttime;
+    /* Number of zombies (upper bound if `error` is non-zero) */
+    size_t zombies;
+    /* Maximum overestimation of `zombies` */
+    size_t error;
+};
+
+/* Struct to be used as a fixed-capacity hash map from PIDs to indexes */
+struct pid_map {
+    pid_t *keys;
+    size_t *values;
+    size_t sz;
+    unsigned int bits;
+};
+
+/* Struct to be used as a fixed-capacity hash map from strings to indexes */
+struct str_map {
+    /* Keys (not owned by the map), `NULL` for empty slots */
+    const char **keys;
+    size_t *values;
+    size_t sz;
+    unsigned int bits;
+};
+
+/* Struct for a single rule of a policy file */
+struct policy_rule {
+    /* Attribute of the parent to match */
+    enum policy_key type;
+    /* Action to take for the matching parents */
+    enum policy_action action;
+    /* Signals to send (only the first one unless escalating) */
+    int signals[POLICY_MAX_SIGNALS];
+    size_t signals_sz;
+    /* Matched parent name, executable or cgroup, `NULL` for UIDs */
+    char *key;
+    /* Matched user ID of the parent */
+    uid_t uid;
+    /* Line of the rule in the policy file */
+    size_t line;
+};
+
+/* Struct for the cached policy decision of a single parent process */
+struct policy_state {
+    /* PID of the parent */
+    pid_t ppid;
+    /* Scan in which `rule` was matched */
+    unsigned long generation;
+    /* Matching rule, `NULL` if none */
+    const struct policy_rule *rule;
+    /* Index of the next signal of an escalating rule */
+    size_t level;
+};
+
+/*
+ * Struct for the per-parent signal rules of a policy file.
+ *
+ * The rules are kept in a hash table per key type, so a parent is matched
+ * with a constant number of lookups. The decisions are cached per parent for
+ * the duration of a scan.
+ */
+struct policy {
+    struct policy_rule *rules;
+    size_t rules_sz;
+    /* Maps from the keys to the rule indexes, `NULL` if there are none */
+    struct str_map *names, *exes, *cgroups;
+    /* Map from `UID + 1` to the rule indexes, `NULL` if there are none */
+    struct pid_map *uids;
+    /* Densely packed decisions of the seen parents */
+    struct policy_state states[POLICY_STATE_SIZE];
+    size_t states_sz;
+    /* Map from the parent's PID to its index in `states` */
+    struct pid_map *index;
+    /* Number of the current scan */
+    unsigned long generation;
+    /* Open `/proc` directory to read the parents' attributes from */
+    int dirfd;
 };
 
-/* Struct for storing process stats */
-struct proc_stats {
+/*
+ * Struct for the append-only journal of the sent signals.
+ *
+ * The records of a scan are buffered and written with a single `write()`
+ * and `fdatasync()` when the scan is committed.
+ */
+struct journal {
+    /* Path of the journal file (rotated to `<path>.1`) */
+    const char *path;
+    int fd;
+    /* Size of the journal file */
+    size_t file_sz;
+    /* Records waiting to be committed */
+    char *buf;
+    size_t buf_sz;
+    size_t buf_cap;
+    /* Open `/proc` directory to look up the parents in (not owned) */
+    int dirfd;
+    /* Last looked up parent and its name */
+    pid_t name_pid;
+    char name[ZPS_TASK_COMM_LEN];
+    /* Error number of the first dropped record, `0` if none */
+    int error;
+};
+
+/* Struct for keeping track of zombie parents across iterations */
+struct leak_table {
+    /* Densely packed entries of the tracked parents */
+    struct leak_entry entries[LEAK_TABLE_SIZE];
+    /* Number of used entries */
+    size_t sz;
+    /* Map from the parent's PID to its index in `entries` */
+    struct pid_map *index;
+    /* Number of the current iteration */
+    unsigned long generation;
+};
+
+/*
+ * Struct for keeping the parents with the most zombies in a bounded min-heap.
+ *
+ * Once the heap is full, a zombie of an untracked parent replaces the parent
+ * with the fewest zombies and inherits its count as the possible error
+ * ("Space-Saving"), so the memory usage only depends on the heap size.
+ */
+struct top_heap {
+    /* Min-heap of the entries ordered by their zombie count */
+    struct top_entry *entries;
+    /* Number of used entries */
+    size_t sz;
+    /* Maximum number of entries */
+    size_t max_sz;
+    /* Map from the parent's PID to its index in `entries` */
+    struct pid_map *index;
+    /* Number of all counted zombies */
+    size_t total;
+};
+
+/* Struct for the fixed-size fields of a process stored in `proc_vec` */
+struct proc_entry {
     pid_t pid;
     pid_t ppid;
+    /* Arena offsets of the process name and the command */
+    uint32_t name_off;
+    uint32_t cmd_off;
     char state;
-    char padding[7];
-    char name[TASK_COMM_LEN];
-    char cmd[CMD_MAX_LEN];
+    char padding[3];
 };
 
-/* Struct to be used as a dynamically growing vector with immutable elements */
+/*
+ * Struct to be used as a dynamically growing vector with immutable elements.
+ *
+ * The fixed-size fields of the processes are kept in a compact array while
+ * the variable-length strings are appended to a bump arena and referred to
+ * by their offset, which is also the layout of the snapshot files.
+ */
 struct proc_vec {
-    struct proc_stats *ptr;
+    struct proc_entry *ptr;
     size_t sz;
     size_t max_sz;
+    /* Null-terminated strings, starting with the empty string */
+    char *arena;
+    size_t arena_sz;
+    size_t arena_max_sz;
+};
+
+/*
+ * Struct for collecting the zombies within a fixed memory budget.
+ *
+ * The zombies are added to a preallocated vector which is written to a
+ * temporary file as a chunk whenever it is full. After the scan, the chunks
+ * are read back into the same vector one at a time. Without a budget, the
+ * vector grows as needed and nothing is written.
+ */
+struct proc_spill {
+    /* Vector of the current chunk */
+    struct proc_vec *chunk;
+    /* Memory budget of `chunk` (in bytes), `0` for none */
+    size_t budget;
+    /* Temporary file of the written chunks, `NULL` until the first one */
+    FILE *file;
+    /* Number of written chunks and the index of the next one to read */
+    size_t chunks, next;
+    /* Boolean value for reading the chunks back (no more additions) */
+    bool reading;
+    /* Boolean value for a failed write or read of the temporary file */
+    bool failed;
+};
+
+/* Struct for the `/proc` scans of live mode */
+struct live_scan {
+    /* Scan context, kept across the scans */
+    struct zps_ctx *ctx;
+    /* Boolean value for a scan in progress */
+    bool active;
+    /* Processes found by the scan in progress */
+    struct proc_vec *pending;
+    /* Processes found by the last complete scan */
+    struct proc_vec *shown;
+    /* Number of scanned processes (in progress, last complete) */
+    size_t scanned, shown_scanned;
+    /* Number of zombies found by the last complete scan */
+    size_t zombies;
+    /* Number of processes scanned since the last frame */
+    size_t chunk;
+    /* Time when the last scan has finished */
+    struct timespec finished;
+};
+
+/* Struct for the screen contents of the current and the previous frame */
+struct live_screen {
+    /* Null-terminated rows of `cols + 1` bytes each (current, previous) */
+    char *cur, *prev;
+    /* Display attributes of the rows (current, previous) */
+    unsigned char *cur_attr, *prev_attr;
+    /* Terminal size */
+    int rows, cols;
+    /* Boolean value for repainting every row in the next frame */
+    bool full_redraw;
 };
 
 /*!
- * Constructs an initial process vector with `max_sz` of `64`.
+ * Constructs an empty process vector with the given initial capacities.
  *
  * The `proc_vec_free()` function should be called on this return value
  * in order to free the resources.
  *
+ * @param[in] max_sz       Number of entries to allocate (at least `1`)
+ * @param[in] arena_max_sz Size of the string arena to allocate (at least `1`)
+ *
  * @return Pointer to the allocated structure, `NULL` on error
  */
-static inline struct proc_vec *proc_vec(void)
+static inline struct proc_vec *proc_vec_sized(size_t max_sz,
+                                              size_t arena_max_sz)
 {
+    assert(max_sz);
+    assert(arena_max_sz);
+
     struct proc_vec *proc_v = (struct proc_vec *)malloc(sizeof(*proc_v));
     if (!proc_v) {
         return NULL;
     }
 
-    proc_v->max_sz = 64;
-    proc_v->sz     = 0;
+    proc_v->max_sz       = max_sz;
+    proc_v->sz           = 0;
+    proc_v->arena_max_sz = arena_max_sz;
+    proc_v->arena_sz     = 1;
     proc_v->ptr =
-        (struct proc_stats *)malloc(proc_v->max_sz * sizeof(*proc_v->ptr));
-    if (!proc_v->ptr) {
+        (struct proc_entry *)malloc(proc_v->max_sz * sizeof(*proc_v->ptr));
+    proc_v->arena = (char *)malloc(proc_v->arena_max_sz);
+    if (!proc_v->ptr || !proc_v->arena) {
+        free(proc_v->ptr);
+        free(proc_v->arena);
         free(proc_v);
         return NULL;
     }
+    /* Offset `0` holds the empty string */
+    proc_v->arena[0] = '\0';
 
     return proc_v;
 }
 
+/*!
+ * Constructs an initial process vector with `max_sz` of `64`.
+ *
+ * The `proc_vec_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @return Pointer to the allocated structure, `NULL` on error
+ */
+static inline struct proc_vec *proc_vec(void)
+{
+    return proc_vec_sized(64, MAX_BUF_SIZE);
+}
+
 /*!
  * Frees and invalidates the process vector pointed to by the `proc_v`.
  *
@@ -159,25 +574,73 @@ static inline void proc_vec_free(struct proc_vec *proc_v)
         return;
     }
     free(proc_v->ptr);
+    free(proc_v->arena);
     free(proc_v);
 }
 
+/*!
+ * Copies the null-terminated string `str` to the end of the arena.
+ *
+ * @param[out] proc_v Process vector to use
+ * @param[in]  str    String to copy
+ * @param[out] off    Pointer to write the arena offset of the copy to
+ *
+ * @return `false` on error, `true` otherwise
+ */
+static inline bool proc_vec_add_str(struct proc_vec *proc_v, const char *str,
+                                    uint32_t *off)
+{
+    assert(proc_v);
+    assert(str);
+    assert(off);
+
+    const size_t len = strlen(str);
+    if (!len) {
+        *off = 0;
+        return true;
+    }
+    if (proc_v->arena_sz + len + 1 > UINT32_MAX) {
+        return false;
+    }
+    if (proc_v->arena_sz + len + 1 > proc_v->arena_max_sz) {
+        size_t max_sz = proc_v->arena_max_sz * 2;
+        while (proc_v->arena_sz + len + 1 > max_sz) {
+            max_sz *= 2;
+        }
+        char *tmp = (char *)realloc(proc_v->arena, max_sz);
+        if (!tmp) {
+            return false;
+        }
+        proc_v->arena        = tmp;
+        proc_v->arena_max_sz = max_sz;
+    }
+
+    *off = (uint32_t)proc_v->arena_sz;
+    memcpy(proc_v->arena + proc_v->arena_sz, str, len + 1);
+    proc_v->arena_sz += len + 1;
+    return true;
+}
+
 /*!
  * Adds `entry` to the end of the `proc_v` vector.
  *
+ * The fixed-size fields are stored in the entry array while the name and
+ * the command are copied to the arena.
+ *
  * @param[out] proc_v Process vector to use
- * @param[in]  entry  Entry to add to the vector
+ * @param[in]  entry  Pointer to the entry to add to the vector
  *
  * @return `false` on error, `true` otherwise
  */
 static inline bool proc_vec_add(struct proc_vec *proc_v,
-                                struct proc_stats entry)
+                                const struct zps_proc *entry)
 {
     assert(proc_v);
+    assert(entry);
 
     if (proc_v->sz == proc_v->max_sz) {
         proc_v->max_sz *= 2;
-        struct proc_stats *tmp = (struct proc_stats *)realloc(
+        struct proc_entry *tmp = (struct proc_entry *)realloc(
             proc_v->ptr, proc_v->max_sz * sizeof(*proc_v->ptr));
         if (!tmp) {
             return false;
@@ -186,7 +649,16 @@ static inline bool proc_vec_add(struct proc_vec *proc_v,
         }
     }
 
-    proc_v->ptr[proc_v->sz++] = entry;
+    struct proc_entry *const dst = &proc_v->ptr[proc_v->sz];
+    dst->pid                     = entry->pid;
+    dst->ppid                    = entry->ppid;
+    dst->state                   = entry->state;
+    if (!proc_vec_add_str(proc_v, entry->name, &dst->name_off) ||
+        !proc_vec_add_str(proc_v, entry->cmd ? entry->cmd : "",
+                          &dst->cmd_off)) {
+        return false;
+    }
+    ++proc_v->sz;
     return true;
 }
 
@@ -198,7 +670,7 @@ static inline bool proc_vec_add(struct proc_vec *proc_v,
  *
  * @return `NULL` if out of bounds, a pointer to the respective entry otherwise
  */
-static inline const struct proc_stats *
+static inline const struct proc_entry *
 proc_vec_at(const struct proc_vec *proc_v, size_t i)
 {
     assert(proc_v);
@@ -206,6 +678,55 @@ proc_vec_at(const struct proc_vec *proc_v, size_t i)
     return i < proc_v->sz ? &proc_v->ptr[i] : NULL;
 }
 
+/*!
+ * Returns the string stored at offset `off` in the arena of `proc_v`.
+ *
+ * @param[in] proc_v Process vector to use
+ * @param[in] off    Arena offset (`name_off` or `cmd_off` of an entry)
+ *
+ * @return Pointer to the null-terminated string
+ */
+static inline const char *proc_vec_str(const struct proc_vec *proc_v,
+                                       uint32_t off)
+{
+    assert(proc_v);
+    assert(off < proc_v->arena_sz);
+
+    return proc_v->arena + off;
+}
+
+/*!
+ * Removes every element from `proc_v` (keeps the allocated memory).
+ *
+ * @param[out] proc_v Process vector to use
+ *
+ * @return void
+ */
+static inline void proc_vec_clear(struct proc_vec *proc_v)
+{
+    assert(proc_v);
+
+    proc_v->sz       = 0;
+    proc_v->arena_sz = 1;
+}
+
+/*!
+ * Sorts the elements of `proc_v` in place.
+ *
+ * @param[in,out] proc_v Process vector to use
+ * @param[in]     cmp    Comparison function as used by `qsort()`
+ *
+ * @return void
+ */
+static inline void proc_vec_sort(struct proc_vec *proc_v,
+                                 int (*cmp)(const void *, const void *))
+{
+    assert(proc_v);
+    assert(cmp);
+
+    qsort(proc_v->ptr, proc_v->sz, sizeof(*proc_v->ptr), cmp);
+}
+
 /*!
  * Returns the current number of elements stored in `proc_v`
  *
@@ -220,4 +741,400 @@ static inline size_t proc_vec_size(const struct proc_vec *proc_v)
     return proc_v->sz;
 }
 
+/*!
+ * Constructs an empty PID map able to hold at least `capacity` keys.
+ *
+ * The `pid_map_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @param[in] capacity Number of keys the map has to be able to hold (at most
+ *                     `SIZE_MAX / 4`)
+ *
+ * @return Pointer to the allocated structure, `NULL` on error
+ */
+static inline struct pid_map *pid_map(size_t capacity)
+{
+    /* The number of slots would overflow */
+    if (capacity > SIZE_MAX / 4) {
+        return NULL;
+    }
+    struct pid_map *map = (struct pid_map *)malloc(sizeof(*map));
+    if (!map) {
+        return NULL;
+    }
+
+    /* Keep the load factor at or below 50% */
+    map->bits = 4;
+    while (((size_t)1 << map->bits) < capacity * 2) {
+        ++map->bits;
+    }
+    map->sz     = 0;
+    map->keys   = (pid_t *)calloc((size_t)1 << map->bits, sizeof(*map->keys));
+    map->values = (size_t *)malloc(((size_t)1 << map->bits) *
+                                   sizeof(*map->values));
+    if (!map->keys || !map->values) {
+        free(map->keys);
+        free(map->values);
+        free(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+/*!
+ * Frees and invalidates the PID map pointed to by the `map`.
+ *
+ * @param[out] map PID map to deallocate
+ *
+ * @return void
+ */
+static inline void pid_map_free(struct pid_map *map)
+{
+    if (!map) {
+        return;
+    }
+    free(map->keys);
+    free(map->values);
+    free(map);
+}
+
+/*!
+ * Returns the home slot of `key` in `map` (Fibonacci hashing).
+ *
+ * @param[in] map PID map to use
+ * @param[in] key PID to hash
+ *
+ * @return Slot index in `[0, 2^bits)`
+ */
+static inline size_t pid_map_slot(const struct pid_map *map, pid_t key)
+{
+    return (size_t)(((uint64_t)(uint32_t)key * UINT64_C(0x9E3779B97F4A7C15)) >>
+                    (64 - map->bits));
+}
+
+/*!
+ * Returns a pointer to the value stored for `key` in `map`.
+ *
+ * @param[in] map PID map to use
+ * @param[in] key PID to look up (must be positive)
+ *
+ * @return `NULL` if not found, a pointer to the respective value otherwise
+ */
+static inline size_t *pid_map_find(const struct pid_map *map, pid_t key)
+{
+    assert(map);
+    assert(key > 0);
+
+    const size_t mask = ((size_t)1 << map->bits) - 1;
+    for (size_t i = pid_map_slot(map, key);; i = (i + 1) & mask) {
+        if (map->keys[i] == key) {
+            return &map->values[i];
+        }
+        if (!map->keys[i]) {
+            return NULL;
+        }
+    }
+}
+
+/*!
+ * Stores `value` for `key` in `map`, replacing the previous value.
+ *
+ * @param[out] map   PID map to use
+ * @param[in]  key   PID to store (must be positive)
+ * @param[in]  value Value to associate with `key`
+ *
+ * @return `false` if the map is full, `true` otherwise
+ */
+static inline bool pid_map_put(struct pid_map *map, pid_t key, size_t value)
+{
+    assert(map);
+    assert(key > 0);
+
+    const size_t mask = ((size_t)1 << map->bits) - 1;
+    size_t i          = pid_map_slot(map, key);
+    for (; map->keys[i] && map->keys[i] != key; i = (i + 1) & mask) {
+    }
+    if (!map->keys[i]) {
+        if (map->sz * 2 >= mask + 1) {
+            return false;
+        }
+        map->keys[i] = key;
+        ++map->sz;
+    }
+    map->values[i] = value;
+
+    return true;
+}
+
+/*!
+ * Removes `key` from `map` (backward shift deletion).
+ *
+ * @param[out] map PID map to use
+ * @param[in]  key PID to remove (must be positive)
+ *
+ * @return `false` if not found, `true` otherwise
+ */
+static inline bool pid_map_remove(struct pid_map *map, pid_t key)
+{
+    assert(map);
+    assert(key > 0);
+
+    const size_t mask = ((size_t)1 << map->bits) - 1;
+    size_t i          = pid_map_slot(map, key);
+    for (; map->keys[i] != key; i = (i + 1) & mask) {
+        if (!map->keys[i]) {
+            return false;
+        }
+    }
+    /* Move back the following entries that would be unreachable otherwise */
+    for (size_t j = (i + 1) & mask; map->keys[j]; j = (j + 1) & mask) {
+        const size_t home = pid_map_slot(map, map->keys[j]);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            map->keys[i]   = map->keys[j];
+            map->values[i] = map->values[j];
+            i              = j;
+        }
+    }
+    map->keys[i] = 0;
+    --map->sz;
+
+    return true;
+}
+
+/*!
+ * Moves the keys of `*map` to a new PID map twice as large.
+ *
+ * @param[in,out] map Pointer to the PID map to replace (kept on error)
+ *
+ * @return `false` on error, `true` otherwise
+ */
+static inline bool pid_map_grow(struct pid_map **map)
+{
+    assert(map);
+    assert(*map);
+
+    struct pid_map *const grown = pid_map((*map)->sz * 2);
+    if (!grown) {
+        return false;
+    }
+    for (size_t i = 0, n = (size_t)1 << (*map)->bits; i < n; ++i) {
+        if ((*map)->keys[i]) {
+            pid_map_put(grown, (*map)->keys[i], (*map)->values[i]);
+        }
+    }
+    pid_map_free(*map);
+    *map = grown;
+
+    return true;
+}
+
+/*!
+ * Removes every key from `map`.
+ *
+ * @param[out] map PID map to use
+ *
+ * @return void
+ */
+static inline void pid_map_clear(struct pid_map *map)
+{
+    assert(map);
+
+    memset(map->keys, 0, ((size_t)1 << map->bits) * sizeof(*map->keys));
+    map->sz = 0;
+}
+
+/*!
+ * Constructs an empty string map able to hold at least `capacity` keys.
+ *
+ * The `str_map_free()` function should be called on this return value
+ * in order to free the resources.
+ *
+ * @param[in] capacity Number of keys the map has to be able to hold (at most
+ *                     `SIZE_MAX / 4`)
+ *
+ * @return Pointer to the allocated structure, `NULL` on error
+ */
+static inline struct str_map *str_map(size_t capacity)
+{
+    /* The number of slots would overflow */
+    if (capacity > SIZE_MAX / 4) {
+        return NULL;
+    }
+    struct str_map *map = (struct str_map *)malloc(sizeof(*map));
+    if (!map) {
+        return NULL;
+    }
+
+    /* Keep the load factor at or below 50% */
+    map->bits = 4;
+    while (((size_t)1 << map->bits) < capacity * 2) {
+        ++map->bits;
+    }
+    map->sz     = 0;
+    map->keys   = (const char **)calloc((size_t)1 << map->bits,
+                                        sizeof(*map->keys));
+    map->values = (size_t *)malloc(((size_t)1 << map->bits) *
+                                   sizeof(*map->values));
+    if (!map->keys || !map->values) {
+        free(map->keys);
+        free(map->values);
+        free(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+/*!
+ * Frees and invalidates the string map pointed to by the `map`.
+ *
+ * @param[out] map String map to deallocate
+ *
+ * @return void
+ */
+static inline void str_map_free(struct str_map *map)
+{
+    if (!map) {
+        return;
+    }
+    free(map->keys);
+    free(map->values);
+    free(map);
+}
+
+/*!
+ * Returns the home slot of `key` in `map` (FNV-1a).
+ *
+ * @param[in] map String map to use
+ * @param[in] key Null-terminated string to hash
+ *
+ * @return Slot index in `[0, 2^bits)`
+ */
+static inline size_t str_map_slot(const struct str_map *map, const char *key)
+{
+    uint64_t hash = UINT64_C(0xCBF29CE484222325);
+    for (; *key; ++key) {
+        hash = (hash ^ (unsigned char)*key) * UINT64_C(0x100000001B3);
+    }
+    return (size_t)(hash >> (64 - map->bits));
+}
+
+/*!
+ * Returns a pointer to the value stored for `key` in `map`.
+ *
+ * @param[in] map String map to use
+ * @param[in] key Null-terminated string to look up
+ *
+ * @return `NULL` if not found, a pointer to the respective value otherwise
+ */
+static inline size_t *str_map_find(const struct str_map *map, const char *key)
+{
+    assert(map);
+    assert(key);
+
+    const size_t mask = ((size_t)1 << map->bits) - 1;
+    for (size_t i = str_map_slot(map, key);; i = (i + 1) & mask) {
+        if (!map->keys[i]) {
+            return NULL;
+        }
+        if (!strcmp(map->keys[i], key)) {
+            return &map->values[i];
+        }
+    }
+}
+
+/*!
+ * Stores `value` for `key` in `map`, replacing the previous value.
+ *
+ * @param[out] map   String map to use
+ * @param[in]  key   Null-terminated string to store (has to outlive `map`)
+ * @param[in]  value Value to associate with `key`
+ *
+ * @return `false` if the map is full, `true` otherwise
+ */
+static inline bool str_map_put(struct str_map *map, const char *key,
+                               size_t value)
+{
+    assert(map);
+    assert(key);
+
+    const size_t mask = ((size_t)1 << map->bits) - 1;
+    size_t i          = str_map_slot(map, key);
+    for (; map->keys[i] && strcmp(map->keys[i], key); i = (i + 1) & mask) {
+    }
+    if (!map->keys[i]) {
+        if (map->sz * 2 >= mask + 1) {
+            return false;
+        }
+        map->keys[i] = key;
+        ++map->sz;
+    }
+    map->values[i] = value;
+
+    return true;
+}
+
+/* Task iterator backend, stubs without `ZPS_BPF` (bpf.c) */
+struct zps_bpf *zps_bpf_open(int dirfd);
+void zps_bpf_close(struct zps_bpf *bpf);
+int zps_bpf_scan(struct zps_bpf *bpf, struct zps_ctx *ctx,
+                 const struct zps_filter *filter, zps_scan_cb cb,
+                 void *userdata);
+
+/* Signal name lookups (signals.c) */
+const char *zps_sig_abbrev(int sig);
+int zps_sig_str_to_num(const char *sig_str);
+int zps_user_signal(const char *sig_str);
+
+/* Per-parent signal rules (policy.c) */
+struct policy *policy_load(const char *path, const char *proc_root,
+                           size_t *line);
+void policy_free(struct policy *policy);
+void policy_next_scan(struct policy *policy);
+int policy_signal(struct policy *policy, pid_t ppid, int sig);
+
+/* Zombies within a memory budget (spill.c) */
+struct proc_spill *proc_spill(size_t budget);
+void proc_spill_free(struct proc_spill *spill);
+bool proc_spill_add(struct proc_spill *spill, const struct zps_proc *entry);
+void proc_spill_rewind(struct proc_spill *spill);
+const struct proc_vec *proc_spill_next(struct proc_spill *spill);
+
+/* Journal of the sent signals (journal.c) */
+struct journal *journal_open(const char *path, int dirfd);
+void journal_close(struct journal *journal);
+const char *journal_name(struct journal *journal, pid_t ppid);
+int journal_record(struct journal *journal, pid_t pid, pid_t ppid,
+                   const char *name, int sig, int err);
+int journal_commit(struct journal *journal);
+
+/* Colored output (output.c) */
+void cfprintf(enum ansi_fg_color_code color, bool color_allowed, FILE *stream,
+              const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+void cbfprintf(enum ansi_fg_color_code color, bool color_allowed, FILE *stream,
+               const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+void cbfprintf_enclosed(enum ansi_fg_color_code color, bool color_allowed,
+                        const char *before, const char *after, FILE *stream,
+                        const char *format, ...)
+    __attribute__((format(printf, 6, 7)));
+
+/* Reading and parsing `/proc` (proc.c) */
+uint64_t zps_perf_begin(const struct zps_perf *perf);
+void zps_perf_end(struct zps_perf *perf, enum zps_phase phase, uint64_t begin);
+ssize_t zps_read_file(int dirfd, char *buf, size_t bufsiz,
+                      struct zps_perf *perf, const char *format, ...)
+    __attribute__((format(printf, 5, 6)));
+int zps_parse_stat_starttime(const char *fields, unsigned long long *starttime);
+int zps_parse_stat_content(char *stat_buf, struct zps_proc *proc_stats);
+int zps_get_proc_stats(int dirfd, const char *pid, struct zps_proc *proc_stats,
+                       struct zps_perf *perf);
+int zps_get_proc_state(int dirfd, const char *pid, struct zps_proc *proc_stats,
+                       struct zps_perf *perf);
+int zps_get_proc_cmd(int dirfd, const char *pid, struct zps_proc *proc_stats,
+                     char *cmd_buf, size_t cmd_bufsiz, struct zps_perf *perf);
+int zps_get_proc_starttime(int dirfd, pid_t pid, unsigned long long *starttime);
+
 #endif // ZPS_H